@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Sensor configuration (persisted in NVS namespace "ble-cfg" as a JSON blob)
+// and the two texts built from it: the stored blob and the config page.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct Config {
+  char ssid[32]       = "ssid";
+  char pass[64]       = "pass";
+  char mqttHost[64]   = "192.168.50.237";
+  uint16_t mqttPort   = 1883;
+  char deviceID[32]   = "BS1";
+  char macList[160]   = "dd:88:00:00:13:07"; // lower-case, comma-separated
+  uint16_t pubMs      = 100;                 // min publish interval per beacon
+};
+
+// NVS blob: {"ssid":..,"pass":..,"mqttHost":..,"mqttPort":..,"deviceID":..,"macList":..,"pubMs":..}
+// snprintf-style: returns the full length; pass (nullptr, 0) to measure.
+size_t configToJson(const Config& c, char* out, size_t cap);
+
+// Config page (GET /). Out is String, FixedText or std::string: anything with += const char*.
+template <typename Out>
+void configFormHtml(Out& html, const Config& cfg, const char* chipId, const char* ip, bool inAP) {
+  char port[8], pubMs[8];
+  snprintf(port, sizeof(port), "%u", (unsigned)cfg.mqttPort);
+  snprintf(pubMs, sizeof(pubMs), "%u", (unsigned)cfg.pubMs);
+
+  html += "<!doctype html><html><head><meta charset='utf-8'>"
+          "<meta name='viewport' content='width=device-width,initial-scale=1'>"
+          "<title>BLE Sensor Config</title><style>"
+          "body{font-family:system-ui,Arial,sans-serif;margin:16px;background:#0b0e14;color:#e6e6e6}"
+          ".card{max-width:780px;margin:auto;background:#141a23;border:1px solid #223042;border-radius:12px;padding:16px}"
+          "label{display:block;margin-top:10px;color:#98a2b3}input{width:100%;padding:8px;border-radius:8px;border:1px solid #223042;background:#0b0e14;color:#e6e6e6}"
+          ".row{display:grid;grid-template-columns:1fr 1fr;gap:12px}.row>div{min-width:0}"
+          ".btn{margin-top:14px;padding:10px 14px;border:0;border-radius:10px;background:#3b82f6;color:#fff;cursor:pointer}"
+          ".muted{color:#98a2b3;font-size:12px;margin-top:6px}</style></head><body><div class='card'>";
+  html += "<h3>BLE Beacon Tracker Sensor Setup ("; html += inAP ? "AP" : "STA"; html += ") - "; html += chipId; html += "</h3>";
+  html += "<div class='muted'>Device IP: "; html += ip; html += " · Host: "; html += cfg.deviceID; html += ".local</div>";
+  html += "<form method='POST' action='/form'>"
+          "<label>Admin token (required to save)</label><input name='token' type='password' placeholder='required'>"
+          "<div class='row'><div>"
+          "<label>Wi-Fi SSID</label><input name='ssid' value='"; html += cfg.ssid; html += "'></div><div>"
+          "<label>Wi-Fi Password</label><input name='pass' type='password' value='"; html += cfg.pass; html += "'></div></div>"
+          "<div class='row'><div>"
+          "<label>MQTT Host</label><input name='mqttHost' value='"; html += cfg.mqttHost; html += "'></div><div>"
+          "<label>MQTT Port</label><input name='mqttPort' type='number' value='"; html += port; html += "'></div></div>"
+          "<div class='row'><div>"
+          "<label>Device ID</label><input name='deviceID' value='"; html += cfg.deviceID; html += "'></div><div>"
+          "<label>Publish Min Interval (ms)</label><input name='pubMs' type='number' value='"; html += pubMs; html += "'></div></div>"
+          "<label>Tracked MACs (comma separated, lowercase)</label>"
+          "<input name='macList' value='"; html += cfg.macList; html += "'>"
+          "<div class='muted'>Example: dd:88:00:00:13:07, a1:b2:c3:d4:e5:f6</div>"
+          "<button class='btn' type='submit'>Save & Reboot</button></form>"
+          "<div class='muted' style='margin-top:10px'>Status: <code>/status</code> · JSON Config: <code>/config</code></div>"
+          "</div></body></html>";
+}
@@ -0,0 +1,86 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Minimal JSON text writer for the fixed-layout documents the sensor emits
+// (MQTT beacon payload, NVS config blob). Works like snprintf: output is
+// truncated to the buffer, length() is what the full text needs.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+class JsonOut {
+ public:
+  JsonOut(char* buf, size_t cap) : buf_(buf), cap_(cap) { if (cap_) buf_[0] = 0; }
+
+  JsonOut& raw(const char* s) { while (*s) put(*s++); return *this; }
+  JsonOut& str(const char* s) {
+    put('"');
+    for (; s && *s; ++s) {
+      const unsigned char c = (unsigned char)*s;
+      if (c == '"' || c == '\\') { put('\\'); put((char)c); }
+      else if (c < 0x20) { char t[8]; snprintf(t, sizeof(t), "\\u%04x", c); raw(t); }
+      else put((char)c);
+    }
+    put('"');
+    return *this;
+  }
+  JsonOut& num(long v)          { char t[24]; snprintf(t, sizeof(t), "%ld", v); return raw(t); }
+  JsonOut& num(unsigned long v) { char t[24]; snprintf(t, sizeof(t), "%lu", v); return raw(t); }
+  // Same digits as ArduinoJson 6 (FloatParts): 9 decimals, one fewer per
+  // integer digit past the first, rounded, trailing zeros stripped
+  JsonOut& num(double v) {
+    if (v != v) return raw("NaN");
+    if (v < 0) { put('-'); v = -v; }
+    if (v > 1.7976931348623157e308) return raw("Infinity");
+    char t[32];
+    if (v >= 1e7 || (v > 0 && v < 1e-5)) {   // ArduinoJson switches to an exponent here
+      snprintf(t, sizeof(t), "%.9g", v);
+      return raw(t);
+    }
+    uint32_t integral = (uint32_t)v, maxDecimal = 1000000000;
+    int places = 9;
+    for (uint32_t i = integral; i >= 10; i /= 10) { maxDecimal /= 10; --places; }
+    double rest = (v - integral) * maxDecimal;
+    uint32_t decimal = (uint32_t)rest;
+    decimal += (uint32_t)((rest - decimal) * 2);
+    if (decimal >= maxDecimal) { decimal = 0; ++integral; }
+    while (places > 0 && decimal % 10 == 0) { decimal /= 10; --places; }
+    if (places) snprintf(t, sizeof(t), "%lu.%0*lu", (unsigned long)integral, places, (unsigned long)decimal);
+    else        snprintf(t, sizeof(t), "%lu", (unsigned long)integral);
+    return raw(t);
+  }
+  // "key": (with a leading comma after the first member)
+  JsonOut& key(const char* k) { if (members_++) put(','); str(k); put(':'); return *this; }
+
+  size_t length() const { return len_; }
+
+ private:
+  void put(char c) {
+    if (len_ + 1 < cap_) { buf_[len_] = c; buf_[len_ + 1] = 0; }
+    ++len_;
+  }
+  char* buf_;
+  size_t cap_, len_ = 0;
+  unsigned members_ = 0;
+};
@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Deferred logging: callers store a binary record (format string address +
+// packed arguments) into a lock-free ring and return immediately; a
+// low-priority task formats the records and writes them to Serial (and to
+// the /log tail when LOG_HTTP=1). When the ring is full the line is dropped
+// and counted, the caller never blocks.
+//
+//   LOG_I(MQTT, "connect failed: state=%d (%s)", st, mqttStateStr(st));
+//
+// Format strings must be literals. Supported conversions: d i u x X o c
+// (with h/l/ll), f e g, s, p. Strings are copied at the call site; all
+// arguments of one call share LogRecord::args (LOG_SLOT_BYTES - 12 bytes,
+// 116 by default), so long strings are cut short. Log lists per item.
+// Not for use from ISRs.
+
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// ===================== Build options =====================
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO   // calls above this level compile to nothing
+#endif
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 32          // power of two
+#endif
+#ifndef LOG_SLOT_BYTES
+#define LOG_SLOT_BYTES 128         // one record incl. header
+#endif
+#ifndef LOG_HTTP
+#define LOG_HTTP 0                 // 1 = keep a text tail for GET /log
+#endif
+#ifndef LOG_HTTP_TAIL
+#define LOG_HTTP_TAIL 2048
+#endif
+
+enum class LogTag : uint8_t { BOOT, NVS, WIFI, HTTP, MQTT, BLE, LOG };
+
+struct LogRecord {
+  const char* fmt;   // format ID: address of the literal in flash
+  uint32_t ms;
+  uint8_t level;
+  LogTag tag;
+  uint16_t len;      // bytes used in args
+  uint8_t args[LOG_SLOT_BYTES - 8 - sizeof(const char*)];
+};
+static_assert(sizeof(LogRecord) == LOG_SLOT_BYTES, "LogRecord layout");
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+void logBegin();                   // start the output task; records logged earlier are kept
+uint32_t logDropped();             // lines lost because the ring was full
+LogRecord* logReserve(uint32_t& pos);
+void logCommit(uint32_t pos);
+size_t logFormat(const LogRecord& r, char* out, size_t cap);
+#if LOG_HTTP
+void logTail(String& out);         // recent formatted output, oldest first
+size_t logTail(char* out, size_t cap); // same into a fixed buffer (newest lines kept); returns length
+#endif
+
+// ===================== Argument packing =====================
+namespace logdetail {
+
+struct Writer { uint8_t* p; uint8_t* end; };
+
+// Bytes an argument needs in the record (strings: at least their NUL)
+template <typename T> struct ArgSize {
+  static constexpr size_t value = (std::is_floating_point<T>::value || sizeof(T) > 4) ? 8 : 4;
+};
+template <typename T> struct ArgSize<T*>  { static constexpr size_t value = 4; };
+template <> struct ArgSize<const char*> { static constexpr size_t value = 1; };
+template <> struct ArgSize<char*>       { static constexpr size_t value = 1; };
+
+template <typename... A> struct RestSize { static constexpr size_t value = 0; };
+template <typename T, typename... A> struct RestSize<T, A...> {
+  static constexpr size_t value = ArgSize<typename std::decay<T>::type>::value + RestSize<A...>::value;
+};
+
+inline void putRaw(Writer& w, size_t rest, const void* v, size_t n) {
+  if ((size_t)(w.end - w.p) < n + rest) return;
+  memcpy(w.p, v, n); w.p += n;
+}
+// Strings are truncated so the arguments after them still fit
+inline void put(Writer& w, size_t rest, const char* s) {
+  size_t room = (size_t)(w.end - w.p);
+  if (room <= rest) return;
+  room -= rest;
+  if (!s) s = "(null)";
+  size_t n = strnlen(s, room - 1);
+  memcpy(w.p, s, n); w.p[n] = 0; w.p += n + 1;
+}
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+put(Writer& w, size_t rest, T v) {
+  if (sizeof(T) > 4) { int64_t x = (int64_t)v; putRaw(w, rest, &x, 8); }
+  else               { int32_t x = (int32_t)v; putRaw(w, rest, &x, 4); }
+}
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+put(Writer& w, size_t rest, T v) { double x = v; putRaw(w, rest, &x, 8); }
+template <typename T>
+typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type, char>::value>::type
+put(Writer& w, size_t rest, const T* v) { uint32_t x = (uint32_t)(uintptr_t)v; putRaw(w, rest, &x, 4); }
+
+inline void encode(Writer&) {}
+template <typename T, typename... A>
+inline void encode(Writer& w, T v, A... rest) {
+  put(w, RestSize<A...>::value, v);
+  encode(w, rest...);
+}
+
+inline void checkFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void checkFormat(const char*, ...) {}
+
+} // namespace logdetail
+
+template <typename... A>
+inline void logWrite(uint8_t level, LogTag tag, const char* fmt, A... args) {
+  uint32_t pos;
+  LogRecord* r = logReserve(pos);
+  if (!r) return;
+  r->fmt = fmt; r->ms = millis(); r->level = level; r->tag = tag;
+  logdetail::Writer w{r->args, r->args + sizeof(r->args)};
+  logdetail::encode(w, args...);
+  r->len = (uint16_t)(w.p - r->args);
+  logCommit(pos);
+}
+
+// ===================== Call-site macros =====================
+#define LOG_AT(lvl, tag, fmt, ...) do {                                   \
+    if ((lvl) <= LOG_LEVEL) {                                             \
+      if (false) logdetail::checkFormat(fmt, ##__VA_ARGS__);              \
+      logWrite((lvl), LogTag::tag, fmt, ##__VA_ARGS__);                   \
+    }                                                                     \
+  } while (0)
+
+#define LOG_E(tag, fmt, ...) LOG_AT(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#define LOG_W(tag, fmt, ...) LOG_AT(LOG_LEVEL_WARN,  tag, fmt, ##__VA_ARGS__)
+#define LOG_I(tag, fmt, ...) LOG_AT(LOG_LEVEL_INFO,  tag, fmt, ##__VA_ARGS__)
+#define LOG_D(tag, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
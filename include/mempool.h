@@ -0,0 +1,121 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Memory budget mode (build with -DMEM_BUDGET=1): JSON documents, HTTP
+// bodies and the NVS config blob come from fixed static storage sized
+// below instead of the heap, so a long-running sensor cannot fragment the
+// RAM it shares with Wi-Fi and NimBLE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef MEM_BUDGET
+#define MEM_BUDGET 0
+#endif
+
+// ===================== Budget (bytes, compile time) =====================
+#ifndef JSON_POOL_BLOCK
+#define JSON_POOL_BLOCK  1024   // one JsonDoc (config / status); fits the full config
+#endif
+#ifndef JSON_POOL_BLOCKS
+#define JSON_POOL_BLOCKS 1      // one doc at a time (handlers never nest them)
+#endif
+#ifndef HTTP_BUF_BYTES
+#define HTTP_BUF_BYTES   3072   // config form page / JSON responses
+#endif
+#ifndef CFG_BLOB_BYTES
+#define CFG_BLOB_BYTES   512    // serialized config in NVS
+#endif
+
+// ===================== Fixed block pool =====================
+// Single-task use (loop task: HTTP handlers, setup). Tracks peak and failures
+// so the budget can be checked on a running sensor.
+template <size_t BlockBytes, size_t Blocks>
+class BlockPool {
+  static_assert(Blocks > 0 && Blocks <= 32, "BlockPool supports 1..32 blocks");
+ public:
+  static constexpr size_t kBlockBytes = BlockBytes;
+  static constexpr size_t kBlocks     = Blocks;
+  static constexpr size_t kBytes      = BlockBytes * Blocks;
+
+  void* alloc(size_t n) {
+    if (n <= BlockBytes) {
+      for (size_t i = 0; i < Blocks; ++i) {
+        if (used_ & (1UL << i)) continue;
+        used_ |= (1UL << i);
+        if (++inUse_ > peak_) peak_ = inUse_;
+        return blocks_[i];
+      }
+    }
+    ++failures_;
+    return nullptr;
+  }
+  void free(void* p) {
+    if (!p) return;
+    size_t i = (size_t)((uint8_t*)p - &blocks_[0][0]) / BlockBytes;
+    if (i < Blocks && (used_ & (1UL << i))) { used_ &= ~(1UL << i); --inUse_; }
+  }
+
+  uint32_t inUse() const    { return inUse_; }
+  uint32_t peak() const     { return peak_; }
+  uint32_t failures() const { return failures_; }
+
+ private:
+  alignas(8) uint8_t blocks_[Blocks][BlockBytes];
+  uint32_t used_ = 0, inUse_ = 0, peak_ = 0, failures_ = 0;
+};
+
+using JsonPool = BlockPool<JSON_POOL_BLOCK, JSON_POOL_BLOCKS>;
+inline JsonPool& jsonPool() { static JsonPool p; return p; }
+
+// Allocator for ArduinoJson's BasicJsonDocument<>: the document takes one
+// whole block for its lifetime; larger capacities fail (empty document).
+struct JsonPoolAllocator {
+  void* allocate(size_t n) { return jsonPool().alloc(n); }
+  void deallocate(void* p) { jsonPool().free(p); }
+  void* reallocate(void* p, size_t n) { return n <= JSON_POOL_BLOCK ? p : nullptr; }
+};
+
+// ===================== Fixed text buffer =====================
+// Drop-in for the `String html; html += ...` pattern; truncates instead of growing.
+class FixedText {
+ public:
+  FixedText(char* buf, size_t cap) : buf_(buf), cap_(cap) { if (cap_) buf_[0] = 0; }
+
+  FixedText& operator+=(const char* s) {
+    if (!s || cap_ == 0) return *this;
+    size_t n = strnlen(s, cap_ - 1 - len_);
+    memcpy(buf_ + len_, s, n); len_ += n; buf_[len_] = 0;
+    if (s[n]) truncated_ = true;
+    return *this;
+  }
+
+  const char* c_str() const { return buf_; }
+  size_t length() const     { return len_; }
+  bool truncated() const    { return truncated_; }
+
+ private:
+  char* buf_;
+  size_t cap_, len_ = 0;
+  bool truncated_ = false;
+};
@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Tracked-beacon table for the scan callback. Fixed size (the NVS macList
+// field holds at most MAX_TARGETS addresses), so matching an advertisement
+// and updating its EMA never touches the heap.
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static constexpr size_t MAX_TARGETS = 8;   // 160-char macList / "xx:xx:xx:xx:xx:xx,"
+
+struct BeaconState { float rssi_ema = NAN; int lastRSSI = 0; uint32_t lastPubMs = 0; };
+
+struct TargetList {
+  char mac[MAX_TARGETS][18];      // "dd:88:00:00:13:07", lower-case
+  uint8_t addr[MAX_TARGETS][6];   // same address in NimBLE byte order (addr[5] first)
+  BeaconState state[MAX_TARGETS];
+  size_t count = 0;
+
+  // Comma-separated, case-insensitive, spaces ignored; malformed entries are skipped
+  void parse(const char* macList);
+  // Index of the advertiser address (NimBLEAddress::getVal() order), or -1
+  int find(const uint8_t val[6]) const;
+};
+
+// EMA used for rssi_ema (alpha 0.3); first sample seeds it
+static inline float rssiEma(float ema, int rssi) {
+  return isnan(ema) ? (float)rssi : 0.3f * rssi + 0.7f * ema;
+}
+
+// One beacon update as published on MQTT_TOPIC
+struct BeaconReport {
+  const char* sensorMac;   // chip ID
+  const char* sensorId;    // cfg.deviceID
+  const char* beaconMac;
+  int rssi;
+  float rssiEma;
+  uint32_t tsUnix;         // UTC seconds
+  uint32_t tsMs;           // uptime ms
+  const char* ip;
+};
+
+// {"sensor_mac":..,"sensor_id":..,"beacon_mac":..,"rssi":..,"rssi_ema":..,"ts_unix":..,"ts_ms":..,"ip":..}
+// snprintf-style: returns the full length, output truncated to cap.
+size_t beaconPayload(const BeaconReport& r, char* out, size_t cap);
@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "config.h"
+#include "jsonout.h"
+
+size_t configToJson(const Config& c, char* out, size_t cap) {
+  JsonOut j(out, cap);
+  j.raw("{");
+  j.key("ssid").str(c.ssid);
+  j.key("pass").str(c.pass);
+  j.key("mqttHost").str(c.mqttHost);
+  j.key("mqttPort").num((unsigned long)c.mqttPort);
+  j.key("deviceID").str(c.deviceID);
+  j.key("macList").str(c.macList);
+  j.key("pubMs").num((unsigned long)c.pubMs);
+  j.raw("}");
+  return j.length();
+}
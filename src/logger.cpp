@@ -0,0 +1,235 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "logger.h"
+
+#include <atomic>
+#include <stdio.h>
+
+// ===================== Ring (bounded MPSC, per-slot sequence numbers) =====================
+// Producers: loop task, NimBLE host task (scan callbacks). Consumer: logTask.
+// Slot i starts with sequence i; it is stored as (seq - i) so the ring is
+// usable from zero-initialised memory, before any constructor or logBegin().
+struct LogSlot {
+  std::atomic<uint32_t> seq;
+  LogRecord rec;
+};
+
+static LogSlot s_ring[LOG_RING_SLOTS];
+static std::atomic<uint32_t> s_head{0};
+static uint32_t s_tail = 0;
+static std::atomic<uint32_t> s_dropped{0};
+static TaskHandle_t s_task = nullptr;
+
+static inline LogSlot& slotAt(uint32_t pos) { return s_ring[pos & (LOG_RING_SLOTS - 1)]; }
+static inline uint32_t slotSeq(uint32_t pos) {
+  return slotAt(pos).seq.load(std::memory_order_acquire) + (pos & (LOG_RING_SLOTS - 1));
+}
+static inline void slotSetSeq(uint32_t pos, uint32_t seq) {
+  slotAt(pos).seq.store(seq - (pos & (LOG_RING_SLOTS - 1)), std::memory_order_release);
+}
+
+LogRecord* logReserve(uint32_t& pos) {
+  pos = s_head.load(std::memory_order_relaxed);
+  for (;;) {
+    int32_t diff = (int32_t)(slotSeq(pos) - pos);
+    if (diff == 0) {
+      if (s_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return &slotAt(pos).rec;
+    } else if (diff < 0) {
+      s_dropped.fetch_add(1, std::memory_order_relaxed); // full: drop, never block the caller
+      return nullptr;
+    } else {
+      pos = s_head.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void logCommit(uint32_t pos) {
+  slotSetSeq(pos, pos + 1);
+  if (s_task) xTaskNotifyGive(s_task);
+}
+
+static bool ringPop(LogRecord& out) {
+  if (slotSeq(s_tail) != s_tail + 1) return false;
+  memcpy(&out, &slotAt(s_tail).rec, sizeof(out));
+  slotSetSeq(s_tail, s_tail + LOG_RING_SLOTS);
+  ++s_tail;
+  return true;
+}
+
+uint32_t logDropped() { return s_dropped.load(std::memory_order_relaxed); }
+
+// ===================== Formatting =====================
+static const char* const TAG_NAMES[] = { "BOOT", "NVS", "WiFi", "HTTP", "MQTT", "BLE", "LOG" };
+static const char LEVEL_CHARS[] = { '-', 'E', 'W', 'I', 'D' };
+
+// Re-applies each printf conversion of r.fmt to the packed argument it consumed.
+size_t logFormat(const LogRecord& r, char* out, size_t cap) {
+  if (cap < 2) return 0;
+  const size_t lim = cap - 1; // room for '\n'
+  uint8_t tag = (uint8_t)r.tag;
+  int w = snprintf(out, lim, "%7lu %c [%s] ", (unsigned long)r.ms,
+                   r.level < sizeof(LEVEL_CHARS) ? LEVEL_CHARS[r.level] : '?',
+                   tag < sizeof(TAG_NAMES) / sizeof(TAG_NAMES[0]) ? TAG_NAMES[tag] : "?");
+  size_t n = (w < 0) ? 0 : ((size_t)w < lim ? (size_t)w : lim - 1);
+
+  const uint8_t* a = r.args;
+  const uint8_t* end = r.args + r.len;
+  auto append = [&](int k) { if (k > 0) n += ((size_t)k < lim - n) ? (size_t)k : lim - 1 - n; };
+
+  for (const char* f = r.fmt; *f && n + 1 < lim; ) {
+    if (*f != '%') { out[n++] = *f++; continue; }
+    if (f[1] == '%') { out[n++] = '%'; f += 2; continue; }
+
+    // %[flags][width][.prec][length]conv -> spec without the length modifier
+    char spec[16]; size_t k = 0; int longs = 0;
+    spec[k++] = *f++;
+    while (*f && strchr("-+ #0123456789.", *f) && k < sizeof(spec) - 4) spec[k++] = *f++;
+    while (*f && strchr("hlLjzt", *f)) { if (*f == 'l') ++longs; if (*f == 'j') longs = 2; ++f; }
+    const char conv = *f ? *f++ : 0;
+    const size_t isz = (longs >= 2 || (longs == 1 && sizeof(long) == 8)) ? 8 : 4;
+
+    switch (conv) {
+      case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c': {
+        if (a + isz > end) { append(snprintf(out + n, lim - n, "?")); break; }
+        long long v;
+        if (isz == 8) { int64_t x; memcpy(&x, a, 8); v = x; }
+        else          { int32_t x; memcpy(&x, a, 4); v = (conv == 'd' || conv == 'i' || conv == 'c') ? x : (long long)(uint32_t)x; }
+        a += isz;
+        if (conv == 'c') { spec[k++] = 'c'; spec[k] = 0; append(snprintf(out + n, lim - n, spec, (int)v)); break; }
+        spec[k++] = 'l'; spec[k++] = 'l'; spec[k++] = conv; spec[k] = 0;
+        append(snprintf(out + n, lim - n, spec, v));
+        break;
+      }
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+        if (a + 8 > end) { append(snprintf(out + n, lim - n, "?")); break; }
+        double v; memcpy(&v, a, 8); a += 8;
+        spec[k++] = conv; spec[k] = 0;
+        append(snprintf(out + n, lim - n, spec, v));
+        break;
+      }
+      case 's': {
+        const char* s = "?";
+        if (a < end) { s = (const char*)a; a += strnlen(s, (size_t)(end - a)) + 1; }
+        spec[k++] = 's'; spec[k] = 0;
+        append(snprintf(out + n, lim - n, spec, s));
+        break;
+      }
+      case 'p': {
+        if (a + 4 > end) { append(snprintf(out + n, lim - n, "?")); break; }
+        uint32_t v; memcpy(&v, a, 4); a += 4;
+        append(snprintf(out + n, lim - n, "0x%08lx", (unsigned long)v));
+        break;
+      }
+      default: break; // unsupported conversion: dropped
+    }
+  }
+  out[n++] = '\n';
+  out[n] = 0;
+  return n;
+}
+
+// ===================== /log tail =====================
+#if LOG_HTTP
+static char s_tailBuf[LOG_HTTP_TAIL];
+static size_t s_tailPos = 0;
+static bool s_tailWrapped = false;
+static SemaphoreHandle_t s_tailMux = nullptr;
+
+static void tailAppend(const char* s, size_t n) {
+  xSemaphoreTake(s_tailMux, portMAX_DELAY);
+  for (size_t i = 0; i < n; ++i) {
+    s_tailBuf[s_tailPos++] = s[i];
+    if (s_tailPos == sizeof(s_tailBuf)) { s_tailPos = 0; s_tailWrapped = true; }
+  }
+  xSemaphoreGive(s_tailMux);
+}
+
+void logTail(String& out) {
+  out = "# dropped=" + String(logDropped()) + "\n";
+  if (!s_tailMux) return;
+  xSemaphoreTake(s_tailMux, portMAX_DELAY);
+  out.reserve(out.length() + sizeof(s_tailBuf));
+  if (s_tailWrapped) {
+    // skip the partial line at the wrap point
+    size_t i = s_tailPos;
+    while (i < sizeof(s_tailBuf) && s_tailBuf[i] != '\n') ++i;
+    if (i < sizeof(s_tailBuf)) out.concat(s_tailBuf + i + 1, sizeof(s_tailBuf) - i - 1);
+  }
+  out.concat(s_tailBuf, s_tailPos);
+  xSemaphoreGive(s_tailMux);
+}
+
+size_t logTail(char* out, size_t cap) {
+  if (cap == 0) return 0;
+  int w = snprintf(out, cap, "# dropped=%lu\n", (unsigned long)logDropped());
+  size_t n = (w < 0) ? 0 : ((size_t)w < cap ? (size_t)w : cap - 1);
+  if (!s_tailMux) return n;
+  xSemaphoreTake(s_tailMux, portMAX_DELAY);
+  // The text is [start, end) of the ring, oldest first; keep the newest lines that fit
+  size_t start = 0, len = s_tailPos;
+  if (s_tailWrapped) {
+    start = s_tailPos; len = sizeof(s_tailBuf);
+    while (len && s_tailBuf[start % sizeof(s_tailBuf)] != '\n') { ++start; --len; }
+    if (len) { ++start; --len; }   // skip the partial line at the wrap point
+  }
+  bool cut = false;
+  while (len > cap - 1 - n || (cut && len && s_tailBuf[(start - 1) % sizeof(s_tailBuf)] != '\n')) {
+    ++start; --len; cut = true;    // drop oldest bytes, then up to a line start
+  }
+  for (size_t i = 0; i < len; ++i) out[n++] = s_tailBuf[(start + i) % sizeof(s_tailBuf)];
+  out[n] = 0;
+  xSemaphoreGive(s_tailMux);
+  return n;
+}
+#endif
+
+// ===================== Output task =====================
+static void logTask(void*) {
+  LogRecord r;
+  char line[192];
+  uint32_t droppedReported = 0;
+  for (;;) {
+    while (ringPop(r)) {
+      size_t n = logFormat(r, line, sizeof(line));
+      Serial.write((const uint8_t*)line, n); // may block on an unattended port; only this task waits
+#if LOG_HTTP
+      tailAppend(line, n);
+#endif
+    }
+    uint32_t d = logDropped();
+    if (d != droppedReported) {
+      int n = snprintf(line, sizeof(line), "%7lu W [LOG] %lu line(s) dropped\n",
+                       (unsigned long)millis(), (unsigned long)(d - droppedReported));
+      Serial.write((const uint8_t*)line, (size_t)n);
+      droppedReported = d;
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+  }
+}
+
+void logBegin() {
+  if (s_task) return;
+#if LOG_HTTP
+  s_tailMux = xSemaphoreCreateMutex();
+#endif
+  xTaskCreate(logTask, "log", 4096, nullptr, tskIDLE_PRIORITY + 1, &s_task);
+}
+
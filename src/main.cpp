@@ -33,15 +33,17 @@
 #include <time.h>
 #include <esp_system.h>   // for esp_read_mac
 #include <esp_wifi.h>     // (optional on some cores)
+#include "config.h"
+#include "logger.h"
+#include "mempool.h"
+#include "scan.h"
 
-#include <unordered_map>
-#include <vector>
+#include <memory>
 #include <string>
-#include <cctype>
 
-// ===================== Debug toggles =====================
-// #define DEBUG_NET   1
-// #define DEBUG_MQTT  1
+// ===================== Logging =====================
+// Level is set at build time (see logger.h), e.g. build_flags = -DLOG_LEVEL=LOG_LEVEL_DEBUG
+// DEBUG shows Wi-Fi credentials/progress and every published beacon update.
 
 // ===================== Hardware / Behavior =====================
 static constexpr int LED_PIN         = 12;    // adjust to your board
@@ -53,16 +55,6 @@ static time_t ts_unix_last_sensor_update = 0; // last unix timestamp when sensor
 static const char* ADMIN_TOKEN = "123456";
 
 // ===================== Config & Globals =====================
-struct Config {
-  char ssid[32]       = "ssid";
-  char pass[64]       = "pass";
-  char mqttHost[64]   = "192.168.50.237";
-  uint16_t mqttPort   = 1883;
-  char deviceID[32]   = "BS1";
-  char macList[160]   = "dd:88:00:00:13:07"; // lower-case, comma-separated
-  uint16_t pubMs      = 100;                 // min publish interval per beacon
-};
-
 Preferences prefs;
 Config cfg;
 std::string chipId;
@@ -70,28 +62,65 @@ WebServer http(80);
 WiFiClient wifiClient;
 PubSubClient mqtt(wifiClient);
 
-struct BeaconState { float rssi_ema = NAN; int lastRSSI = 0; uint32_t lastPubMs = 0; };
-std::unordered_map<std::string, BeaconState> states;
-std::string mac; // currently detected MAC in scan callback
-std::string mac_filtered; // currently detected MAC after filtering
+TargetList targets;                     // tracked beacons + per-beacon state
+static volatile int g_lastTarget = -1;  // index of the last matched beacon (for /status)
 
 static bool g_inAPMode = false;
 static volatile bool g_timeReady = false;
 
+// ===================== Memory budget =====================
+// MEM_BUDGET=1: JSON docs, HTTP bodies and the NVS blob use static storage (mempool.h)
+#if MEM_BUDGET
+using JsonDoc = BasicJsonDocument<JsonPoolAllocator>;
+static constexpr size_t CFG_DOC_BYTES    = JSON_POOL_BLOCK;
+static constexpr size_t STATUS_DOC_BYTES = JSON_POOL_BLOCK;
+static char g_httpBuf[HTTP_BUF_BYTES];
+static char g_cfgBlob[CFG_BLOB_BYTES];
+static constexpr size_t CFG_BLOB_LIMIT   = CFG_BLOB_BYTES;  // stored blob + NUL must fit
+#else
+using JsonDoc = DynamicJsonDocument;
+static constexpr size_t CFG_DOC_BYTES    = 4096;
+static constexpr size_t STATUS_DOC_BYTES = 1024;
+static constexpr size_t CFG_BLOB_LIMIT   = 4096;
+#endif
+static constexpr uint16_t MQTT_BUF_BYTES = 512;  // PubSubClient packet buffer (heap, allocated once)
+
+// Per-subsystem RAM reserved at build time, plus the heap as seen at boot
+static void printMemBudget() {
+#if MEM_BUDGET
+  LOG_I(BOOT, "RAM budget: json=%u (%ux%u) http=%u nvs=%u",
+        (unsigned)JsonPool::kBytes, (unsigned)JsonPool::kBlocks, (unsigned)JsonPool::kBlockBytes,
+        (unsigned)sizeof(g_httpBuf), (unsigned)sizeof(g_cfgBlob));
+#endif
+  LOG_I(BOOT, "RAM budget: scan=%u log=%u mqtt=%u",
+        (unsigned)sizeof(targets), (unsigned)(LOG_RING_SLOTS * LOG_SLOT_BYTES), (unsigned)MQTT_BUF_BYTES);
+  LOG_I(BOOT, "heap: free=%u max_block=%u", (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMaxAllocHeap());
+}
+
 // ===================== Helpers =====================
 static inline const char* showStr(const char* s) { return (s && *s) ? s : "(empty)"; }
 
-// Pretty-print current config to Serial
+// Pretty-print current config to the log
 static void printConfig() {
-  Serial.println(F("=== NVS Config (namespace: ble-cfg) ==="));
-  Serial.printf("ssid:        %s\n", showStr(cfg.ssid));
-  Serial.printf("pass:        %s\n", showStr(cfg.pass)); //(*cfg.pass) ? "********" : "(empty)");
-  Serial.printf("mqttHost:    %s\n", showStr(cfg.mqttHost));
-  Serial.printf("mqttPort:    %u\n", cfg.mqttPort);
-  Serial.printf("deviceID:    %s\n", showStr(cfg.deviceID));
-  Serial.printf("macList:     %s\n", showStr(cfg.macList));
-  Serial.printf("pubMs:       %u\n", cfg.pubMs);
-  Serial.println(F("======================================="));
+  LOG_I(NVS, "=== NVS Config (namespace: ble-cfg) ===");
+  LOG_I(NVS, "ssid:        %s", showStr(cfg.ssid));
+  LOG_I(NVS, "pass:        %s", showStr(cfg.pass)); //(*cfg.pass) ? "********" : "(empty)");
+  LOG_I(NVS, "mqttHost:    %s", showStr(cfg.mqttHost));
+  LOG_I(NVS, "mqttPort:    %u", cfg.mqttPort);
+  LOG_I(NVS, "deviceID:    %s", showStr(cfg.deviceID));
+  // One record per entry: the whole list can exceed a log record's argument space
+  if (!*cfg.macList) LOG_I(NVS, "macList:     (empty)");
+  unsigned i = 0;
+  for (const char* p = cfg.macList; *p; ) {
+    size_t n = strcspn(p, ",");
+    char item[32];
+    strlcpy(item, p, n + 1 < sizeof(item) ? n + 1 : sizeof(item));
+    LOG_I(NVS, "macList[%u]:  %s", i++, item);
+    p += n;
+    if (*p) ++p;
+  }
+  LOG_I(NVS, "pubMs:       %u", cfg.pubMs);
+  LOG_I(NVS, "=======================================");
 }
 
 // Load config from NVS; auto-create namespace if missing; print values
@@ -103,19 +132,27 @@ static void loadConfig(bool verbose = true) {
       prefs.end();
       prefs.begin("ble-cfg", true);
     } else {
-      if (verbose) Serial.println(F("[NVS] Failed to open/create namespace (ble-cfg)"));
+      if (verbose) LOG_E(NVS, "Failed to open/create namespace (ble-cfg)");
       return;
     }
   }
 
   size_t need = prefs.getBytesLength("json");
-  if (need > 0 && need < 4096) {
-    std::unique_ptr<char[]> buf(new char[need + 1]);
-    prefs.getBytes("json", buf.get(), need);
+  if (need >= CFG_BLOB_LIMIT) {
+    if (verbose) LOG_W(NVS, "Stored config too large (%u B, max %u), using defaults",
+                       (unsigned)need, (unsigned)(CFG_BLOB_LIMIT - 1));
+  } else if (need > 0) {
+#if MEM_BUDGET
+    char* buf = g_cfgBlob;
+#else
+    std::unique_ptr<char[]> owner(new char[need + 1]);
+    char* buf = owner.get();
+#endif
+    prefs.getBytes("json", buf, need);
     buf[need] = 0;
 
-    DynamicJsonDocument d(4096);
-    if (deserializeJson(d, buf.get()) == DeserializationError::Ok) {
+    JsonDoc d(CFG_DOC_BYTES);
+    if (deserializeJson(d, (const char*)buf) == DeserializationError::Ok) {
       strlcpy(cfg.ssid,       d["ssid"]       | cfg.ssid,       sizeof(cfg.ssid));
       strlcpy(cfg.pass,       d["pass"]       | cfg.pass,       sizeof(cfg.pass));
       strlcpy(cfg.mqttHost,   d["mqttHost"]   | cfg.mqttHost,   sizeof(cfg.mqttHost));
@@ -124,46 +161,50 @@ static void loadConfig(bool verbose = true) {
       strlcpy(cfg.macList,    d["macList"]    | cfg.macList,    sizeof(cfg.macList));
       cfg.pubMs =              d["pubMs"]     | cfg.pubMs;
     } else if (verbose) {
-      Serial.println(F("[NVS] JSON parse error, using defaults"));
+      LOG_W(NVS, "JSON parse error, using defaults");
     }
   } else if (verbose) {
-    Serial.println(F("[NVS] No existing config, using defaults"));
+    LOG_I(NVS, "No existing config, using defaults");
   }
 
   prefs.end();
   if (verbose) printConfig();
 }
 
-// Save selected fields to NVS (no token ever)
-static void saveConfigFromJson(const JsonVariantConst& d) {
-  DynamicJsonDocument out(4096);
-  out["ssid"]       = d["ssid"]       | cfg.ssid;
-  out["pass"]       = d["pass"]       | cfg.pass;
-  out["mqttHost"]   = d["mqttHost"]   | cfg.mqttHost;
-  out["mqttPort"]   = d["mqttPort"]   | cfg.mqttPort;
-  out["deviceID"]   = d["deviceID"]   | cfg.deviceID;
-  out["macList"]    = d["macList"]    | cfg.macList;
-  out["pubMs"]      = d["pubMs"]      | cfg.pubMs;
-
-  String s; serializeJson(out, s);
+// Save selected fields to NVS (no token ever); false if nothing was saved
+static bool saveConfigFromJson(const JsonVariantConst& d) {
+  Config next = cfg;
+  strlcpy(next.ssid,       d["ssid"]       | cfg.ssid,       sizeof(next.ssid));
+  strlcpy(next.pass,       d["pass"]       | cfg.pass,       sizeof(next.pass));
+  strlcpy(next.mqttHost,   d["mqttHost"]   | cfg.mqttHost,   sizeof(next.mqttHost));
+  next.mqttPort =          d["mqttPort"]   | cfg.mqttPort;
+  strlcpy(next.deviceID,   d["deviceID"]   | cfg.deviceID,   sizeof(next.deviceID));
+  strlcpy(next.macList,    d["macList"]    | cfg.macList,    sizeof(next.macList));
+  next.pubMs =             d["pubMs"]      | cfg.pubMs;
+
+  size_t len = configToJson(next, nullptr, 0);
+  if (len >= CFG_BLOB_LIMIT) {
+    LOG_E(NVS, "Config too large (%u B, max %u), not saved", (unsigned)len, (unsigned)(CFG_BLOB_LIMIT - 1));
+    return false;
+  }
+#if MEM_BUDGET
+  char* blob = g_cfgBlob;
+#else
+  std::unique_ptr<char[]> owner(new char[len + 1]);
+  char* blob = owner.get();
+#endif
+  configToJson(next, blob, len + 1);
   if (!prefs.begin("ble-cfg", false)) {
-    Serial.println(F("[NVS] Failed to open ble-cfg for write"));
-    return;
+    LOG_E(NVS, "Failed to open ble-cfg for write");
+    return false;
   }
-  prefs.putBytes("json", s.c_str(), s.length());
+  prefs.putBytes("json", blob, len);
   prefs.end();
 
-  // Reflect into RAM immediately
-  strlcpy(cfg.ssid,       out["ssid"],       sizeof(cfg.ssid));
-  strlcpy(cfg.pass,       out["pass"],       sizeof(cfg.pass));
-  strlcpy(cfg.mqttHost,   out["mqttHost"],   sizeof(cfg.mqttHost));
-  cfg.mqttPort =          out["mqttPort"];
-  strlcpy(cfg.deviceID, out["deviceID"], sizeof(cfg.deviceID));
-  strlcpy(cfg.macList,    out["macList"],    sizeof(cfg.macList));
-  cfg.pubMs =             out["pubMs"];
-
-  Serial.println(F("[NVS] Saved config:"));
+  cfg = next; // reflect into RAM immediately
+  LOG_I(NVS, "Saved config:");
   printConfig();
+  return true;
 }
 
 // ===================== SNTP time =====================
@@ -210,70 +251,71 @@ static void ledUpdate() {
 // ===================== Wi-Fi =====================
 static bool wifiConnect(uint32_t timeoutMs = 15000) {
   ledSetMode(LedMode::CONNECTING_FAST);
-#if DEBUG_NET
-  Serial.printf("[WiFi] Connecting to SSID='%s', Pass: '%s'\n", cfg.ssid, cfg.pass);
-#endif
+  LOG_D(WIFI, "Connecting to SSID='%s', Pass: '%s'", cfg.ssid, cfg.pass);
   WiFi.mode(WIFI_STA);
   WiFi.begin(cfg.ssid, cfg.pass);
   uint32_t t0 = millis(), lastDot = 0;
   while (WiFi.status() != WL_CONNECTED && (millis() - t0) < timeoutMs) {
     ledUpdate();
-    if (millis() - lastDot > 500) { lastDot = millis(); Serial.print("."); }
+    if (millis() - lastDot > 500) { lastDot = millis(); LOG_D(WIFI, "waiting (%lu ms)", (unsigned long)(lastDot - t0)); }
     delay(20);
   }
   bool ok = WiFi.status() == WL_CONNECTED;
-#if DEBUG_NET
-  Serial.println();
   if (ok) {
-    Serial.printf("[WiFi] OK. IP=%s  RSSI=%d dBm\n",
-      WiFi.localIP().toString().c_str(), WiFi.RSSI());
+    LOG_D(WIFI, "OK. IP=%s  RSSI=%d dBm", WiFi.localIP().toString().c_str(), WiFi.RSSI());
   } else {
-    Serial.println("[WiFi] FAILED");
+    LOG_D(WIFI, "FAILED");
   }
-#endif
   ledSetMode(ok ? LedMode::ONLINE_HEARTBEAT : LedMode::OFF);
   return ok;
 }
 
 // ===================== Web UI =====================
+static void ipToStr(const IPAddress& ip, char (&out)[16]) {
+  snprintf(out, sizeof(out), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
+static void sendJson(JsonDoc& d) {
+#if MEM_BUDGET
+  size_t n = serializeJson(d, g_httpBuf, sizeof(g_httpBuf));
+  http.send_P(200, "application/json", g_httpBuf, n);
+#else
+  String body; serializeJson(d, body); http.send(200, "application/json", body);
+#endif
+}
+
+#if LOG_HTTP
+static void sendLogTail() {
+#if MEM_BUDGET
+  size_t n = logTail(g_httpBuf, sizeof(g_httpBuf));
+  http.send_P(200, "text/plain", g_httpBuf, n);
+#else
+  String body; logTail(body); http.send(200, "text/plain", body);
+#endif
+}
+#endif
+
 static void sendConfigForm(bool inAP) {
-  String ip = inAP ? WiFi.softAPIP().toString() : WiFi.localIP().toString();
-  String title = String("BLE Beacon Tracker Sensor Setup (") + (inAP ? "AP" : "STA") + ") - " + String(chipId.c_str());
+  char ip[16]; ipToStr(inAP ? WiFi.softAPIP() : WiFi.localIP(), ip);
 
+#if MEM_BUDGET
+  FixedText html(g_httpBuf, sizeof(g_httpBuf));
+#else
   String html;
   html.reserve(3000);
-  html += F("<!doctype html><html><head><meta charset='utf-8'>"
-            "<meta name='viewport' content='width=device-width,initial-scale=1'>"
-            "<title>BLE Sensor Config</title><style>"
-            "body{font-family:system-ui,Arial,sans-serif;margin:16px;background:#0b0e14;color:#e6e6e6}"
-            ".card{max-width:780px;margin:auto;background:#141a23;border:1px solid #223042;border-radius:12px;padding:16px}"
-            "label{display:block;margin-top:10px;color:#98a2b3}input{width:100%;padding:8px;border-radius:8px;border:1px solid #223042;background:#0b0e14;color:#e6e6e6}"
-            ".row{display:grid;grid-template-columns:1fr 1fr;gap:12px}.row>div{min-width:0}"
-            ".btn{margin-top:14px;padding:10px 14px;border:0;border-radius:10px;background:#3b82f6;color:#fff;cursor:pointer}"
-            ".muted{color:#98a2b3;font-size:12px;margin-top:6px}</style></head><body><div class='card'>");
-  html += "<h3>" + title + "</h3>";
-  html += "<div class='muted'>Device IP: " + ip + " · Host: " + String(cfg.deviceID) + ".local</div>";
-  html += F("<form method='POST' action='/form'>"
-            "<label>Admin token (required to save)</label><input name='token' type='password' placeholder='required'>"
-            "<div class='row'><div>"
-            "<label>Wi-Fi SSID</label><input name='ssid' value='"); html += cfg.ssid; html += F("'></div><div>"
-            "<label>Wi-Fi Password</label><input name='pass' type='password' value='"); html += cfg.pass; html += F("'></div></div>"
-            "<div class='row'><div>"
-            "<label>MQTT Host</label><input name='mqttHost' value='"); html += cfg.mqttHost; html += F("'></div><div>"
-            "<label>MQTT Port</label><input name='mqttPort' type='number' value='"); html += String(cfg.mqttPort); html += F("'></div></div>"
-            "<div class='row'><div>"
-            "<label>Device ID</label><input name='deviceID' value='"); html += cfg.deviceID; html += F("'></div><div>"
-            "<label>Publish Min Interval (ms)</label><input name='pubMs' type='number' value='"); html += String(cfg.pubMs); html += F("'></div></div>"
-            "<label>Tracked MACs (comma separated, lowercase)</label>"
-            "<input name='macList' value='"); html += cfg.macList; html += F("'>"
-            "<div class='muted'>Example: dd:88:00:00:13:07, a1:b2:c3:d4:e5:f6</div>"
-            "<button class='btn' type='submit'>Save & Reboot</button></form>"
-            "<div class='muted' style='margin-top:10px'>Status: <code>/status</code> · JSON Config: <code>/config</code></div>"
-            "</div></body></html>");
+#endif
+  configFormHtml(html, cfg, chipId.c_str(), ip, inAP);
+#if MEM_BUDGET
+  if (html.truncated()) {
+    LOG_E(HTTP, "Config page exceeds HTTP_BUF_BYTES (%u), not sent", (unsigned)sizeof(g_httpBuf));
+    http.send(500, "text/plain", "page too large");
+    return;
+  }
+#endif
 
   http.setContentLength(CONTENT_LENGTH_UNKNOWN);
   http.send(200, "text/html", "");
-  http.sendContent(html);
+  http.sendContent_P(html.c_str(), html.length());
 }
 
 static void handleFormPost() {
@@ -282,7 +324,7 @@ static void handleFormPost() {
     http.send(403, "text/plain", "Forbidden: bad token");
     return;
   }
-  DynamicJsonDocument d(4096);
+  JsonDoc d(CFG_DOC_BYTES);
   d["ssid"]       = http.arg("ssid");
   d["pass"]       = http.arg("pass");
   d["mqttHost"]   = http.arg("mqttHost");
@@ -292,7 +334,10 @@ static void handleFormPost() {
   d["pubMs"]      = http.arg("pubMs").toInt();
   // no token saved
 
-  saveConfigFromJson(d.as<JsonVariantConst>());
+  if (!saveConfigFromJson(d.as<JsonVariantConst>())) {
+    http.send(500, "text/plain", "Save failed");
+    return;
+  }
 
   http.setContentLength(CONTENT_LENGTH_UNKNOWN);
   http.send(200, "text/html", "");
@@ -316,18 +361,19 @@ static void startAPForProvision() {
   http.on("/", HTTP_GET, [](){ sendConfigForm(true); });
   http.on("/form", HTTP_POST, handleFormPost);
   http.on("/status", HTTP_GET, [](){
-    DynamicJsonDocument s(1024);
-    s["chip"] = chipId.c_str(); s["mode"] = "AP"; s["ip"] = WiFi.softAPIP().toString();
-    String body; serializeJson(s, body); http.send(200, "application/json", body);
+    JsonDoc s(STATUS_DOC_BYTES);
+    char ip[16]; ipToStr(WiFi.softAPIP(), ip);
+    s["chip"] = chipId.c_str(); s["mode"] = "AP"; s["ip"] = ip;
+    sendJson(s);
   });
   // JSON config endpoint (token required; never persisted)
   http.on("/config", HTTP_POST, [](){
-    DynamicJsonDocument d(4096);
+    JsonDoc d(CFG_DOC_BYTES);
     DeserializationError e = deserializeJson(d, http.arg("plain"));
     if (e) { http.send(400, "text/plain", "bad json"); return; }
     if (strcmp(d["token"] | "", ADMIN_TOKEN) != 0) { http.send(403, "text/plain", "bad token"); return; }
     d.remove("token"); // never store
-    saveConfigFromJson(d);
+    if (!saveConfigFromJson(d)) { http.send(500, "text/plain", "save failed"); return; }
     http.send(200, "text/plain", "saved, rebooting"); delay(500); ESP.restart();
   });
 
@@ -338,18 +384,22 @@ static void startHttpSTA() {
   http.on("/", HTTP_GET, [](){ sendConfigForm(false); });
   http.on("/form", HTTP_POST, handleFormPost);
   http.on("/status", HTTP_GET, [](){
-    DynamicJsonDocument s(1024);
-    s["chip"]=chipId.c_str(); s["mode"]="STA"; s["ip"]=WiFi.localIP().toString();
+    JsonDoc s(STATUS_DOC_BYTES);
+    char ip[16]; ipToStr(WiFi.localIP(), ip);
+    s["chip"]=chipId.c_str(); s["mode"]="STA"; s["ip"]=ip;
     s["ssid"]=cfg.ssid; s["mqttHost"]=cfg.mqttHost; s["mqttPort"]=cfg.mqttPort;
-    String body; serializeJson(s, body); http.send(200, "application/json", body);
+    sendJson(s);
   });
+#if LOG_HTTP
+  http.on("/log", HTTP_GET, sendLogTail);
+#endif
   http.on("/config", HTTP_POST, [](){
-    DynamicJsonDocument d(4096);
+    JsonDoc d(CFG_DOC_BYTES);
     DeserializationError e = deserializeJson(d, http.arg("plain"));
     if (e) { http.send(400, "text/plain", "bad json"); return; }
     if (strcmp(d["token"] | "", ADMIN_TOKEN) != 0) { http.send(403, "text/plain", "bad token"); return; }
     d.remove("token");
-    saveConfigFromJson(d);
+    if (!saveConfigFromJson(d)) { http.send(500, "text/plain", "save failed"); return; }
     http.send(200, "text/plain", "saved, rebooting"); delay(500); ESP.restart();
   });
   http.begin();
@@ -375,6 +425,7 @@ static void startMDNS() {
 
 // ===================== MQTT =====================
 
+static const char* MQTT_TOPIC = "sensors/ble/";
 unsigned long g_nextMqttRetryMs = 0;
 uint8_t g_mqttRetries = 0;
 
@@ -402,22 +453,23 @@ void mqttConnectRobust() {
 
   mqtt.setServer(cfg.mqttHost, cfg.mqttPort);
   mqtt.setKeepAlive(30);
-  mqtt.setBufferSize(512);
-  std::string clientId  = std::string("ble-") + cfg.deviceID;
-  std::string willTopic = std::string("sensors/ble/") + cfg.deviceID + "/status";
+  mqtt.setBufferSize(MQTT_BUF_BYTES);
+  char clientId[40], willTopic[64];
+  snprintf(clientId, sizeof(clientId), "ble-%s", cfg.deviceID);
+  snprintf(willTopic, sizeof(willTopic), "%s%s/status", MQTT_TOPIC, cfg.deviceID);
 
   // Close any half-open TCP before new attempt
   wifiClient.stop();
 
-  Serial.printf("[MQTT] Connecting to %s:%u as %s\n", cfg.mqttHost, cfg.mqttPort, clientId.c_str());
+  LOG_I(MQTT, "Connecting to %s:%u as %s", cfg.mqttHost, cfg.mqttPort, clientId);
 
-  bool ok = mqtt.connect(clientId.c_str(),
-                         /*willTopic*/ willTopic.c_str(), /*willQos*/ 0, /*willRetain*/ true,
+  bool ok = mqtt.connect(clientId,
+                         /*willTopic*/ willTopic, /*willQos*/ 0, /*willRetain*/ true,
                          /*willMessage*/ "offline");
 
   if (!ok) {
     int st = mqtt.state();
-    Serial.printf("[MQTT] connect failed: state=%d (%s)\n", st, mqttStateStr(st));
+    LOG_W(MQTT, "connect failed: state=%d (%s)", st, mqttStateStr(st));
     // Backoff: 0.5s,1s,2s,... up to 60s
     g_mqttRetries = (g_mqttRetries < 8) ? g_mqttRetries + 1 : 8;
     unsigned long delayMs = 500UL * (1UL << (g_mqttRetries - 1));
@@ -429,28 +481,24 @@ void mqttConnectRobust() {
   // Success
   g_mqttRetries = 0;
   g_nextMqttRetryMs = 0;
-  mqtt.publish(willTopic.c_str(), "online", true);
-  Serial.println("[MQTT] connected.");
+  mqtt.publish(willTopic, "online", true);
+  LOG_I(MQTT, "connected.");
 }
 
 
 // ===================== BLE scanning =====================
-static std::vector<std::string> targetMacs;
-
 class ScanCB : public NimBLEScanCallbacks {
   void onResult(const NimBLEAdvertisedDevice* adv) override {
-    mac = adv->getAddress().toString();
-    for (char &c : mac) c = (char)std::tolower((unsigned char)c);
-
-    bool match = false;
-    for (auto& m : targetMacs) { if (mac == m) { match = true; break; } }
-    if (!match) return;
+    // Match on raw address bytes: no string is built for the (many) untracked advertisers
+    int idx = targets.find(adv->getAddress().getVal());
+    if (idx < 0) return;
 
-    mac_filtered = mac;
+    g_lastTarget = idx;
+    const char* mac = targets.mac[idx];
 
     int rssi = adv->getRSSI();
-    auto &st = states[mac];
-    if (isnan(st.rssi_ema)) st.rssi_ema = rssi; else st.rssi_ema = 0.3f * rssi + 0.7f * st.rssi_ema;
+    BeaconState &st = targets.state[idx];
+    st.rssi_ema = rssiEma(st.rssi_ema, rssi);
 
     ts_unix_last_sensor_update = nowUnix();
 
@@ -458,30 +506,18 @@ class ScanCB : public NimBLEScanCallbacks {
     if (t - st.lastPubMs < cfg.pubMs) return;
 
     // JSON (no distance)
-    StaticJsonDocument<256> d;
-    d["sensor_mac"]  = chipId.c_str();
-    d["sensor_id"]  = cfg.deviceID;
-    d["beacon_mac"]     = mac.c_str();
-    d["rssi"]    = rssi;
-    d["rssi_ema"]     = st.rssi_ema;
-    d["ts_unix"] = (uint32_t) nowUnix(); // UTC seconds
-    d["ts_ms"]   = (uint32_t) millis();  // uptime ms
-    d["ip"]      = WiFi.localIP().toString();
-
-    char buf[256]; size_t n = serializeJson(d, buf);
-    std::string topic = std::string("sensors/ble/");
-
-#if DEBUG_MQTT
-    Serial.print("[MQTT] ");
-    Serial.print(topic.c_str());
-    Serial.print(" ");
-    Serial.write(buf, n);
-    Serial.println();
-#endif
+    char ip[16]; ipToStr(WiFi.localIP(), ip);
+    BeaconReport rep{chipId.c_str(), cfg.deviceID, mac, rssi, st.rssi_ema,
+                     (uint32_t)nowUnix() /* UTC seconds */, (uint32_t)millis() /* uptime ms */, ip};
+    char buf[256];
+    size_t n = beaconPayload(rep, buf, sizeof(buf));
+    if (n >= sizeof(buf)) { LOG_W(MQTT, "payload too long (%u B), dropped", (unsigned)n); return; }
+
+    LOG_D(MQTT, "%s beacon=%s rssi=%d ema=%.1f (%u B)", MQTT_TOPIC, mac, rssi, st.rssi_ema, (unsigned)n);
 
-    bool pubOK = mqtt.publish(topic.c_str(), (const uint8_t*)buf, (unsigned int)n);
+    bool pubOK = mqtt.publish(MQTT_TOPIC, (const uint8_t*)buf, (unsigned int)n);
     if (!pubOK) {
-      Serial.println("[MQTT] publish failed; scheduling reconnect");
+      LOG_W(MQTT, "publish failed; scheduling reconnect");
       mqtt.disconnect();
       g_nextMqttRetryMs = 0;  // allow immediate retry
     }
@@ -509,6 +545,7 @@ void setup() {
     Serial.begin(115200);
     unsigned long t = millis();
     while (!Serial && millis() - t < 3000) { delay(10); }
+    logBegin();
 
     pinMode(LED_PIN, OUTPUT); digitalWrite(LED_PIN, LOW);
     pinMode(AP_TRIGGER_PIN, INPUT_PULLUP);
@@ -521,59 +558,67 @@ void setup() {
     // Build deviceId from full 48-bit STA MAC (unique)
     uint8_t mac_esp[6];
     esp_read_mac(mac_esp, ESP_MAC_WIFI_STA);  // STA MAC straight from eFuse
-    Serial.printf("[BOOT] MCU_MAC = %02X:%02X:%02X:%02X:%02X:%02X\n", mac_esp[0], mac_esp[1], mac_esp[2], mac_esp[3], mac_esp[4], mac_esp[5]);
+    LOG_I(BOOT, "MCU_MAC = %02X:%02X:%02X:%02X:%02X:%02X", mac_esp[0], mac_esp[1], mac_esp[2], mac_esp[3], mac_esp[4], mac_esp[5]);
     
     char idbuf[13]; // 12 hex + NUL
     snprintf(idbuf, sizeof(idbuf), "%02X%02X%02X%02X%02X%02X", mac_esp[0], mac_esp[1], mac_esp[2], mac_esp[3], mac_esp[4], mac_esp[5]);
     chipId = idbuf;
     
     loadConfig(true);  // prints NVS content
+    printMemBudget();
 
     // If Wi-Fi not configured (factory default), go straight to AP mode
     if (strcmp(cfg.ssid, "ssid") == 0 || cfg.ssid[0] == '\0') {
-        Serial.println("[BOOT] No Wi-Fi configured → entering AP provisioning");
+        LOG_I(BOOT, "No Wi-Fi configured → entering AP provisioning");
         enterAPModeNow();
         return;
     }
 
 
-    // Parse MAC list into vector<string>
-    targetMacs.clear();
-    { String s = cfg.macList; s.toLowerCase(); s += ","; int p = 0;
-        while (true) { int q = s.indexOf(',', p); if (q < 0) break;
-        String m = s.substring(p, q); m.trim(); if (m.length() == 17) targetMacs.emplace_back(m.c_str()); p = q + 1; } }
+    // Parse MAC list into the fixed target table
+    targets.parse(cfg.macList);
 
-    if (stayedLow) { Serial.println("AP trigger at boot → AP mode"); enterAPModeNow(); return; }
+    if (stayedLow) { LOG_I(BOOT, "AP trigger at boot → AP mode"); enterAPModeNow(); return; }
 
     if (!wifiConnect(15000)) {
-        Serial.println("Wi-Fi join failed → Rebooting");
+        LOG_E(WIFI, "Wi-Fi join failed → Rebooting");
         delay(500); ESP.restart();
         return;
     }
 
-    Serial.printf("Wi-Fi OK, IP=%s\n", WiFi.localIP().toString().c_str());
+    LOG_I(WIFI, "Wi-Fi OK, IP=%s", WiFi.localIP().toString().c_str());
     setupTime();
     // Start STA HTTP routes
     http.on("/", HTTP_GET, [](){ sendConfigForm(false); });
     http.on("/form", HTTP_POST, handleFormPost);
     http.on("/status", HTTP_GET, [](){
-        DynamicJsonDocument s(1024);
-        s["chip"]=chipId.c_str(); s["mode"]="STA"; s["ip"]=WiFi.localIP().toString();
+        JsonDoc s(STATUS_DOC_BYTES);
+        char ip[16]; ipToStr(WiFi.localIP(), ip);
+        s["chip"]=chipId.c_str(); s["mode"]="STA"; s["ip"]=ip;
         s["ssid"]=cfg.ssid; s["mqttHost"]=cfg.mqttHost; s["mqttPort"]=cfg.mqttPort;
-        s["beacon_mac"] = mac_filtered.c_str(); s["rssi_ema"] = states[mac_filtered].rssi_ema;
+        int last = g_lastTarget;
+        s["beacon_mac"] = last >= 0 ? targets.mac[last] : ""; s["rssi_ema"] = last >= 0 ? targets.state[last].rssi_ema : NAN;
         s["ts_unix"] = (uint32_t) ts_unix_last_sensor_update; s["ts_ms"] = (uint32_t) millis();
         s["state"]      = mqttStateStr(mqtt.state());   // readable string
         s["retries"]    = g_mqttRetries;
         s["next_retry_ms"] = (millis() > g_nextMqttRetryMs) ? 0 : (g_nextMqttRetryMs - millis());
-        String body; serializeJson(s, body); http.send(200, "application/json", body);
+        s["log_dropped"] = logDropped();
+        s["heap_free"] = ESP.getFreeHeap(); s["heap_min_free"] = ESP.getMinFreeHeap(); s["heap_max_block"] = ESP.getMaxAllocHeap();
+#if MEM_BUDGET
+        s["json_pool_peak"] = jsonPool().peak(); s["json_pool_fail"] = jsonPool().failures();
+#endif
+        sendJson(s);
     });
+#if LOG_HTTP
+    http.on("/log", HTTP_GET, sendLogTail);
+#endif
     http.on("/config", HTTP_POST, [](){
-        DynamicJsonDocument d(4096);
+        JsonDoc d(CFG_DOC_BYTES);
         DeserializationError e = deserializeJson(d, http.arg("plain"));
         if (e) { http.send(400, "text/plain", "bad json"); return; }
         if (strcmp(d["token"] | "", ADMIN_TOKEN) != 0) { http.send(403, "text/plain", "bad token"); return; }
         d.remove("token");
-        saveConfigFromJson(d);
+        if (!saveConfigFromJson(d)) { http.send(500, "text/plain", "save failed"); return; }
         http.send(200, "text/plain", "saved, rebooting"); delay(500); ESP.restart();
     });
     http.begin();
@@ -595,7 +640,7 @@ void loop() {
     int level = digitalRead(AP_TRIGGER_PIN);
     if (level == LOW) {
       if (lowSince == 0) lowSince = millis();
-      if (millis() - lowSince >= AP_HOLD_MS) { Serial.println("AP trigger at runtime → AP mode"); enterAPModeNow(); }
+      if (millis() - lowSince >= AP_HOLD_MS) { LOG_I(BOOT, "AP trigger at runtime → AP mode"); enterAPModeNow(); }
     } else lowSince = 0;
   }
 
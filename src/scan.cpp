@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "scan.h"
+#include "jsonout.h"
+
+#include <ctype.h>
+#include <string.h>
+
+static int hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+void TargetList::parse(const char* macList) {
+  count = 0;
+  char tok[18]; size_t n = 0; bool tooLong = false;
+  for (const char* p = macList ? macList : "";; ++p) {
+    const char c = *p;
+    if (c == ',' || c == 0) {
+      if (n == 17 && !tooLong && count < MAX_TARGETS) {
+        tok[17] = 0;
+        bool ok = true;
+        for (int i = 0; i < 6 && ok; ++i) {
+          int hi = hexNibble(tok[i * 3]), lo = hexNibble(tok[i * 3 + 1]);
+          ok = hi >= 0 && lo >= 0 && (i == 5 || tok[i * 3 + 2] == ':');
+          if (ok) addr[count][5 - i] = (uint8_t)(hi << 4 | lo);
+        }
+        if (ok) { memcpy(mac[count], tok, sizeof(tok)); state[count] = BeaconState(); ++count; }
+      }
+      n = 0; tooLong = false;
+      if (c == 0) break;
+      continue;
+    }
+    if (isspace((unsigned char)c)) continue;
+    if (n < 17) tok[n++] = (char)tolower((unsigned char)c); else tooLong = true;
+  }
+}
+
+int TargetList::find(const uint8_t val[6]) const {
+  for (size_t i = 0; i < count; ++i) if (memcmp(addr[i], val, 6) == 0) return (int)i;
+  return -1;
+}
+
+size_t beaconPayload(const BeaconReport& r, char* out, size_t cap) {
+  JsonOut j(out, cap);
+  j.raw("{");
+  j.key("sensor_mac").str(r.sensorMac);
+  j.key("sensor_id").str(r.sensorId);
+  j.key("beacon_mac").str(r.beaconMac);
+  j.key("rssi").num((long)r.rssi);
+  j.key("rssi_ema").num((double)r.rssiEma);
+  j.key("ts_unix").num((unsigned long)r.tsUnix);
+  j.key("ts_ms").num((unsigned long)r.tsMs);
+  j.key("ip").str(r.ip);
+  j.raw("}");
+  return j.length();
+}
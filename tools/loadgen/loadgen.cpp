@@ -0,0 +1,688 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Synthetic sensor-fleet load generator (Linux host tool).
+//
+// Emulates N sensors x M beacons against an MQTT broker, producing the same
+// topics and payloads as src/main.cpp:
+//   - beacon updates (onResult JSON) on      sensors/ble/
+//   - retained online / will "offline" on   sensors/ble/<deviceID>/status
+// A monitor client subscribes to the same topics (and $SYS/broker/#) to
+// measure end-to-end publish latency and delivery.
+//
+// Only MQTT 3.1.1 QoS0 is needed, so a minimal client is implemented here
+// directly on POSIX sockets (no external dependencies). The beacon payload
+// comes from the firmware's own src/scan.cpp.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "scan.h"   // BeaconState, rssiEma(), beaconPayload() from the firmware
+
+// ===================== Firmware constants (mirror src/main.cpp) =====================
+static constexpr uint16_t MQTT_KEEPALIVE_S   = 30;     // mqtt.setKeepAlive(30)
+static constexpr uint32_t MQTT_SOCKET_TO_MS  = 15000;  // PubSubClient MQTT_SOCKET_TIMEOUT
+static constexpr uint8_t  MQTT_MAX_RETRIES   = 8;      // backoff cap in mqttConnectRobust()
+static constexpr uint32_t MQTT_MAX_BACKOFF   = 60000;
+static constexpr size_t   SENSOR_TX_CAP      = 5744;   // ~lwIP TCP_SND_BUF on ESP32; beyond this publish() fails
+static const char*        DATA_TOPIC         = "sensors/ble/";
+
+// ===================== Options =====================
+struct Options {
+  std::string host     = "127.0.0.1";
+  uint16_t port        = 1883;
+  int sensors          = 30;
+  int beacons          = 1;
+  uint32_t pubMs       = 100;    // cfg.pubMs: min publish interval per beacon
+  uint32_t advMs       = 100;    // beacon advertising interval
+  uint32_t jitterMs    = 10;     // random extra delay per advertisement (BLE advDelay)
+  uint32_t rampMs      = 2000;   // spread sensor boots over this window
+  uint32_t durationS   = 60;
+  uint32_t reportS     = 5;
+  uint32_t drainMs     = 2000;   // keep the monitor running after the last publish
+  uint32_t stormEveryS = 0;      // 0 = off; abruptly drop every sensor at this period
+  uint32_t outageEveryS = 0;     // 0 = off; Wi-Fi outage period
+  uint32_t outageMs    = 5000;
+  double outageFrac    = 0.1;    // fraction of sensors hit by each outage
+  std::string idPrefix = "BS";
+  bool monitor         = true;
+  uint32_t seed        = 1;
+};
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  --host H            broker host (default 127.0.0.1)\n"
+    "  --port P            broker port (default 1883)\n"
+    "  --sensors N         emulated sensors (default 30)\n"
+    "  --beacons M         beacons heard by every sensor (default 1)\n"
+    "  --pub-ms MS         per-beacon min publish interval, cfg.pubMs (default 100)\n"
+    "  --adv-ms MS         beacon advertising interval (default 100)\n"
+    "  --jitter-ms MS      random extra delay per advertisement (default 10)\n"
+    "  --ramp-ms MS        spread sensor boots over this window (default 2000)\n"
+    "  --duration S        run time in seconds (default 60)\n"
+    "  --report S          report interval in seconds (default 5)\n"
+    "  --drain-ms MS       monitor drain time after the run (default 2000)\n"
+    "  --storm-every S     drop all sensors abruptly every S seconds (default off)\n"
+    "  --outage-every S    Wi-Fi outage every S seconds (default off)\n"
+    "  --outage-ms MS      Wi-Fi outage length (default 5000)\n"
+    "  --outage-frac F     fraction of sensors per outage (default 0.1)\n"
+    "  --id-prefix P       deviceID prefix (default BS -> BS1..BSN)\n"
+    "  --no-monitor        do not subscribe; no latency / delivery stats\n"
+    "  --seed N            RNG seed (default 1)\n",
+    argv0);
+}
+
+static bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    auto val = [&](const char*& out) {
+      if (i + 1 >= argc) { fprintf(stderr, "missing value for %s\n", a.c_str()); return false; }
+      out = argv[++i]; return true;
+    };
+    const char* v = nullptr;
+    if      (a == "--no-monitor") { o.monitor = false; continue; }
+    else if (a == "-h" || a == "--help") { usage(argv[0]); exit(0); }
+    if (!val(v)) return false;
+    if      (a == "--host")         o.host = v;
+    else if (a == "--port")         o.port = (uint16_t)atoi(v);
+    else if (a == "--sensors")      o.sensors = atoi(v);
+    else if (a == "--beacons")      o.beacons = atoi(v);
+    else if (a == "--pub-ms")       o.pubMs = (uint32_t)atol(v);
+    else if (a == "--adv-ms")       o.advMs = (uint32_t)atol(v);
+    else if (a == "--jitter-ms")    o.jitterMs = (uint32_t)atol(v);
+    else if (a == "--ramp-ms")      o.rampMs = (uint32_t)atol(v);
+    else if (a == "--duration")     o.durationS = (uint32_t)atol(v);
+    else if (a == "--report")       o.reportS = (uint32_t)atol(v);
+    else if (a == "--drain-ms")     o.drainMs = (uint32_t)atol(v);
+    else if (a == "--storm-every")  o.stormEveryS = (uint32_t)atol(v);
+    else if (a == "--outage-every") o.outageEveryS = (uint32_t)atol(v);
+    else if (a == "--outage-ms")    o.outageMs = (uint32_t)atol(v);
+    else if (a == "--outage-frac")  o.outageFrac = atof(v);
+    else if (a == "--id-prefix")    o.idPrefix = v;
+    else if (a == "--seed")         o.seed = (uint32_t)atol(v);
+    else { fprintf(stderr, "unknown option %s\n", a.c_str()); return false; }
+  }
+  if (o.sensors < 1 || o.beacons < 1 || o.beacons > 0xFFFF || o.advMs == 0 || o.reportS == 0) {
+    fprintf(stderr, "invalid sensors/beacons/adv-ms/report\n");
+    return false;
+  }
+  return true;
+}
+
+// ===================== Time =====================
+static const auto g_t0 = std::chrono::steady_clock::now();
+static uint64_t nowUs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now() - g_t0).count();
+}
+static uint64_t nowMs() { return nowUs() / 1000; }
+
+static volatile sig_atomic_t g_stop = 0;
+static void onSignal(int) { g_stop = 1; }
+
+// ===================== Minimal MQTT 3.1.1 =====================
+static void putLen(std::string& s, size_t n) {
+  do { uint8_t b = n % 128; n /= 128; if (n) b |= 0x80; s += (char)b; } while (n);
+}
+static void putStr(std::string& s, const std::string& v) {
+  s += (char)(v.size() >> 8); s += (char)(v.size() & 0xFF); s += v;
+}
+static void packet(std::string& out, uint8_t hdr, const std::string& body) {
+  out += (char)hdr; putLen(out, body.size()); out += body;
+}
+
+static void mqttConnect(std::string& out, const std::string& clientId, uint16_t keepAlive,
+                        const std::string& willTopic, const char* willMsg) {
+  std::string b;
+  putStr(b, "MQTT");
+  b += (char)4;                                           // protocol level 3.1.1
+  b += (char)(willTopic.empty() ? 0x02 : 0x02 | 0x04 | 0x20); // clean | will | will retain (qos0)
+  b += (char)(keepAlive >> 8); b += (char)(keepAlive & 0xFF);
+  putStr(b, clientId);
+  if (!willTopic.empty()) { putStr(b, willTopic); putStr(b, willMsg); }
+  packet(out, 0x10, b);
+}
+static void mqttPublish(std::string& out, const std::string& topic, const char* payload, size_t n, bool retain) {
+  std::string b;
+  putStr(b, topic);
+  b.append(payload, n);
+  packet(out, (uint8_t)(0x30 | (retain ? 1 : 0)), b);
+}
+static void mqttSubscribe(std::string& out, uint16_t pid, const std::vector<std::string>& filters) {
+  std::string b;
+  b += (char)(pid >> 8); b += (char)(pid & 0xFF);
+  for (auto& f : filters) { putStr(b, f); b += (char)0; }
+  packet(out, 0x82, b);
+}
+static void mqttPing(std::string& out)       { out += (char)0xC0; out += (char)0; }
+static void mqttDisconnect(std::string& out) { out += (char)0xE0; out += (char)0; }
+
+// Pops one complete packet from `in` starting at `off`. Returns false if more bytes are needed.
+static bool nextPacket(const std::string& in, size_t& off, uint8_t& hdr, const char*& body, size_t& len) {
+  if (in.size() - off < 2) return false;
+  size_t p = off + 1, n = 0, mul = 1;
+  for (int i = 0; i < 4; ++i) {
+    if (p >= in.size()) return false;
+    uint8_t b = (uint8_t)in[p++];
+    n += (b & 0x7F) * mul; mul *= 128;
+    if (!(b & 0x80)) break;
+  }
+  if (in.size() - p < n) return false;
+  hdr = (uint8_t)in[off]; body = in.data() + p; len = n;
+  off = p + n;
+  return true;
+}
+
+// ===================== Sockets =====================
+struct Conn {
+  int fd = -1;
+  std::string in, out;
+};
+
+static void connClose(Conn& c, bool abortive) {
+  if (c.fd < 0) return;
+  if (abortive) { linger l{1, 0}; setsockopt(c.fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l)); } // RST, like a dead radio
+  close(c.fd);
+  c.fd = -1; c.in.clear(); c.out.clear();
+}
+
+static sockaddr_storage g_addr;
+static socklen_t g_addrLen = 0;
+
+static bool resolve(const Options& o) {
+  addrinfo hints{}, *res = nullptr;
+  hints.ai_socktype = SOCK_STREAM;
+  std::string port = std::to_string(o.port);
+  if (getaddrinfo(o.host.c_str(), port.c_str(), &hints, &res) != 0 || !res) return false;
+  memcpy(&g_addr, res->ai_addr, res->ai_addrlen); g_addrLen = res->ai_addrlen;
+  freeaddrinfo(res);
+  return true;
+}
+
+// Non-blocking connect; returns false on immediate failure.
+static bool connOpen(Conn& c) {
+  c.fd = socket(g_addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (c.fd < 0) return false;
+  int one = 1; setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (connect(c.fd, (sockaddr*)&g_addr, g_addrLen) < 0 && errno != EINPROGRESS) { connClose(c, false); return false; }
+  return true;
+}
+
+static bool connFlush(Conn& c) {
+  size_t off = 0;
+  while (off < c.out.size()) {
+    ssize_t n = send(c.fd, c.out.data() + off, c.out.size() - off, MSG_NOSIGNAL);
+    if (n > 0) { off += (size_t)n; continue; }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    return false;
+  }
+  c.out.erase(0, off);
+  return true;
+}
+
+static bool connRead(Conn& c) {
+  char buf[65536];
+  for (;;) {
+    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+    if (n > 0) { c.in.append(buf, (size_t)n); if ((size_t)n < sizeof(buf)) return true; continue; }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    return false; // EOF or error
+  }
+}
+
+// ===================== Stats =====================
+struct Stats {
+  uint64_t published = 0, delivered = 0, undelivered = 0;
+  uint64_t pubFailed = 0;                 // publish() returned false (disconnected or TX buffer full)
+  uint64_t connAttempts = 0, connFailed = 0, connOk = 0, dropped = 0;
+  uint64_t online = 0, offline = 0;       // non-retained status messages seen by the monitor
+  std::vector<uint32_t> latUs;            // end-to-end publish latency samples
+};
+
+static void percentiles(std::vector<uint32_t>& v, double& p50, double& p99, double& pmax) {
+  p50 = p99 = pmax = NAN;
+  if (v.empty()) return;
+  auto at = [&](double q) {
+    size_t k = std::min(v.size() - 1, (size_t)(q * (double)(v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + (long)k, v.end());
+    return v[k] / 1000.0;
+  };
+  p50 = at(0.50); p99 = at(0.99);
+  pmax = *std::max_element(v.begin(), v.end()) / 1000.0;
+}
+
+// ===================== Emulated sensor =====================
+enum class SensorState { IDLE, TCP_CONNECTING, WAIT_CONNACK, ONLINE };
+
+struct SimBeacon : BeaconState { int baseRssi = -70; };
+
+struct Sensor {
+  Conn conn;
+  SensorState state = SensorState::IDLE;
+  std::string deviceID, chipId, ip, clientId, willTopic;
+  uint64_t bootMs = 0;                  // millis() origin of this emulated sensor
+  uint64_t nextRetryMs = 0;             // g_nextMqttRetryMs
+  uint8_t retries = 0;                  // g_mqttRetries
+  uint64_t attemptMs = 0, lastInMs = 0, lastOutMs = 0;
+  bool pingOutstanding = false;
+  uint64_t wifiDownUntilMs = 0;
+  std::vector<SimBeacon> states;
+
+  uint32_t millis(uint64_t now) const { return (uint32_t)(now - bootMs); }
+  bool wifiUp(uint64_t now) const { return now >= wifiDownUntilMs; }
+};
+
+struct AdvEvent {
+  uint64_t atMs; int sensor; int beacon;
+  bool operator>(const AdvEvent& o) const { return atMs > o.atMs; }
+};
+
+static Options g_opt;
+static Stats g_stats, g_ivl;
+static std::vector<Sensor> g_sensors;
+static std::vector<std::string> g_beaconMacs;
+static std::mt19937 g_rng;
+
+// Sent-but-not-yet-seen publishes per sensor_id|beacon_mac, in publish order (QoS0 keeps order per client).
+static std::unordered_map<std::string, std::deque<std::pair<uint32_t, uint64_t>>> g_inflight;
+
+static void sensorBackoff(Sensor& s, uint64_t now) {
+  // Backoff: 0.5s,1s,2s,... up to 60s
+  s.retries = (s.retries < MQTT_MAX_RETRIES) ? s.retries + 1 : MQTT_MAX_RETRIES;
+  uint64_t delayMs = 500ULL * (1ULL << (s.retries - 1));
+  if (delayMs > MQTT_MAX_BACKOFF) delayMs = MQTT_MAX_BACKOFF;
+  s.nextRetryMs = now + delayMs;
+  s.state = SensorState::IDLE;
+  ++g_stats.connFailed; ++g_ivl.connFailed;
+}
+
+// Connection lost while online: firmware retries on the next loop() (no backoff slot pending).
+static void sensorLost(Sensor& s, bool abortive) {
+  connClose(s.conn, abortive);
+  s.state = SensorState::IDLE;
+  ++g_stats.dropped; ++g_ivl.dropped;
+}
+
+// mqttConnectRobust(): one attempt when Wi-Fi is up and the backoff slot is reached.
+static void sensorConnect(Sensor& s, uint64_t now) {
+  if (!s.wifiUp(now) || now < s.nextRetryMs) return;
+  connClose(s.conn, false);           // wifiClient.stop()
+  ++g_stats.connAttempts; ++g_ivl.connAttempts;
+  s.attemptMs = now;
+  if (!connOpen(s.conn)) { sensorBackoff(s, now); return; }
+  mqttConnect(s.conn.out, s.clientId, MQTT_KEEPALIVE_S, s.willTopic, "offline");
+  s.state = SensorState::TCP_CONNECTING;
+}
+
+static void sensorOnPacket(Sensor& s, uint8_t hdr, const char* body, size_t len, uint64_t now) {
+  switch (hdr >> 4) {
+    case 2: // CONNACK
+      if (s.state != SensorState::WAIT_CONNACK) break;
+      if (len >= 2 && body[1] == 0) {
+        s.retries = 0; s.nextRetryMs = 0;
+        s.state = SensorState::ONLINE;
+        s.lastInMs = s.lastOutMs = now; s.pingOutstanding = false;
+        mqttPublish(s.conn.out, s.willTopic, "online", 6, true);
+        ++g_stats.connOk; ++g_ivl.connOk;
+      } else {
+        connClose(s.conn, false);
+        sensorBackoff(s, now);
+      }
+      break;
+    case 13: s.pingOutstanding = false; break; // PINGRESP
+    default: break;
+  }
+}
+
+// onResult(): EMA update and rate-limited publish, payload built by the firmware's beaconPayload().
+static void sensorOnAdv(Sensor& s, int bi, uint64_t now) {
+  if (now < s.bootMs) return; // not powered up yet (--ramp)
+  static std::normal_distribution<float> noise(0.0f, 4.0f);
+  SimBeacon& st = s.states[bi];
+  int rssi = std::max(-120, std::min(0, st.baseRssi + (int)std::lround(noise(g_rng))));
+  st.rssi_ema = rssiEma(st.rssi_ema, rssi);
+
+  uint32_t t = s.millis(now);
+  if (t - st.lastPubMs < g_opt.pubMs) return;
+  st.lastPubMs = t;
+  if (s.state != SensorState::ONLINE) {
+    // mqtt.publish() fails while disconnected; the firmware then calls
+    // mqtt.disconnect() and clears g_nextMqttRetryMs, cancelling the backoff
+    ++g_stats.pubFailed; ++g_ivl.pubFailed;
+    s.nextRetryMs = 0;
+    return;
+  }
+
+  BeaconReport rep{s.chipId.c_str(), s.deviceID.c_str(), g_beaconMacs[bi].c_str(), rssi, st.rssi_ema,
+                   (uint32_t)time(nullptr), t, s.ip.c_str()};
+  char buf[256];
+  size_t n = beaconPayload(rep, buf, sizeof(buf));
+  if (n >= sizeof(buf)) return;
+
+  // lwIP send buffer full (slow broker or dead link) -> publish() fails -> disconnect, immediate retry
+  if (s.conn.out.size() + n + 16 > SENSOR_TX_CAP) {
+    ++g_stats.pubFailed; ++g_ivl.pubFailed;
+    mqttDisconnect(s.conn.out); if (s.wifiUp(now)) connFlush(s.conn);
+    sensorLost(s, false);
+    s.nextRetryMs = 0;
+    return;
+  }
+  mqttPublish(s.conn.out, DATA_TOPIC, buf, n, false);
+  s.lastOutMs = now;
+  ++g_stats.published; ++g_ivl.published;
+  if (g_opt.monitor) g_inflight[s.deviceID + "|" + g_beaconMacs[bi]].emplace_back(t, nowUs());
+}
+
+// Keepalive and timeouts, as PubSubClient::loop() / connect() would.
+static void sensorTick(Sensor& s, uint64_t now) {
+  switch (s.state) {
+    case SensorState::IDLE: sensorConnect(s, now); break;
+    case SensorState::TCP_CONNECTING:
+    case SensorState::WAIT_CONNACK:
+      if (now - s.attemptMs > MQTT_SOCKET_TO_MS) { connClose(s.conn, false); sensorBackoff(s, now); }
+      break;
+    case SensorState::ONLINE: {
+      if (!s.wifiUp(now)) break;  // loop() skips mqtt.loop() while Wi-Fi is down: no pings
+      const uint64_t ka = MQTT_KEEPALIVE_S * 1000ULL;
+      if (now - s.lastInMs > ka || now - s.lastOutMs > ka) {
+        if (s.pingOutstanding) { sensorLost(s, true); break; }
+        mqttPing(s.conn.out); s.lastOutMs = now; s.lastInMs = now; s.pingOutstanding = true;
+      }
+      break;
+    }
+  }
+}
+
+// ===================== Monitor (subscriber) =====================
+static constexpr uint16_t MONITOR_KEEPALIVE_S = 60;
+static Conn g_mon;
+static uint64_t g_monLastOutMs = 0;               // the broker only counts client->broker traffic
+static std::map<std::string, std::string> g_sys; // latest $SYS/broker/... values
+
+static std::string jsonStr(const char* p, size_t n, const char* key) {
+  std::string k = std::string("\"") + key + "\":\"";
+  const char* e = p + n;
+  const char* f = std::search(p, e, k.begin(), k.end());
+  if (f == e) return {};
+  f += k.size();
+  const char* q = std::find(f, e, '"');
+  return std::string(f, q);
+}
+static bool jsonU32(const char* p, size_t n, const char* key, uint32_t& v) {
+  std::string k = std::string("\"") + key + "\":";
+  const char* e = p + n;
+  const char* f = std::search(p, e, k.begin(), k.end());
+  if (f == e) return false;
+  v = (uint32_t)strtoul(std::string(f + k.size(), std::find(f + k.size(), e, ',')).c_str(), nullptr, 10);
+  return true;
+}
+
+static void monitorOnPublish(uint8_t hdr, const char* body, size_t len) {
+  if (len < 2) return;
+  size_t tl = ((uint8_t)body[0] << 8) | (uint8_t)body[1];
+  if (2 + tl > len) return;
+  std::string topic(body + 2, tl);
+  const char* pl = body + 2 + tl; size_t pn = len - 2 - tl;  // QoS0: no packet id
+  bool retained = hdr & 0x01;
+
+  if (topic == DATA_TOPIC) {
+    uint64_t rx = nowUs();
+    uint32_t ts = 0;
+    std::string key = jsonStr(pl, pn, "sensor_id") + "|" + jsonStr(pl, pn, "beacon_mac");
+    if (!jsonU32(pl, pn, "ts_ms", ts)) return;
+    auto it = g_inflight.find(key);
+    if (it == g_inflight.end()) return; // someone else's traffic
+    auto& q = it->second;
+    while (!q.empty() && q.front().first != ts) { q.pop_front(); ++g_stats.undelivered; ++g_ivl.undelivered; }
+    if (q.empty()) return;
+    uint32_t lat = (uint32_t)std::min<uint64_t>(rx - q.front().second, UINT32_MAX);
+    q.pop_front();
+    ++g_stats.delivered; ++g_ivl.delivered;
+    g_stats.latUs.push_back(lat); g_ivl.latUs.push_back(lat);
+  } else if (topic.compare(0, 5, "$SYS/") == 0) {
+    g_sys[topic] = std::string(pl, pn);
+  } else if (!retained && topic.size() > 7 && topic.compare(topic.size() - 7, 7, "/status") == 0) {
+    std::string v(pl, pn);
+    if (v == "online")  { ++g_stats.online;  ++g_ivl.online; }
+    if (v == "offline") { ++g_stats.offline; ++g_ivl.offline; }
+  }
+}
+
+static bool monitorStart() {
+  if (!connOpen(g_mon)) return false;
+  pollfd p{g_mon.fd, POLLOUT, 0};
+  int err = 0; socklen_t el = sizeof(err);
+  if (poll(&p, 1, (int)MQTT_SOCKET_TO_MS) != 1 || getsockopt(g_mon.fd, SOL_SOCKET, SO_ERROR, &err, &el) || err) return false;
+  mqttConnect(g_mon.out, "loadgen-monitor-" + std::to_string(getpid()), MONITOR_KEEPALIVE_S, "", nullptr);
+  mqttSubscribe(g_mon.out, 1, {"sensors/ble/#", "$SYS/broker/#"});
+  g_monLastOutMs = nowMs();
+  return connFlush(g_mon);
+}
+
+// The monitor only reads; ping so the broker does not drop it after 1.5 x keepalive
+static void monitorTick(uint64_t now) {
+  if (g_mon.fd < 0 || now - g_monLastOutMs < MONITOR_KEEPALIVE_S * 1000ULL) return;
+  mqttPing(g_mon.out);
+  g_monLastOutMs = now;
+}
+
+// ===================== Report =====================
+static void report(const char* tag, Stats& s, double secs) {
+  double p50, p99, pmax;
+  percentiles(s.latUs, p50, p99, pmax);
+  int online = 0;
+  for (auto& x : g_sensors) if (x.state == SensorState::ONLINE) ++online;
+  printf("%-6s t=%6.1fs online=%d/%d pub=%.0f/s rx=%.0f/s lost=%llu pubfail=%llu "
+         "conn=%llu ok=%llu fail=%llu drop=%llu will=%llu",
+         tag, nowMs() / 1000.0, online, (int)g_sensors.size(),
+         s.published / secs, s.delivered / secs, (unsigned long long)s.undelivered,
+         (unsigned long long)s.pubFailed, (unsigned long long)s.connAttempts,
+         (unsigned long long)s.connOk, (unsigned long long)s.connFailed,
+         (unsigned long long)s.dropped, (unsigned long long)s.offline);
+  if (g_opt.monitor && !s.latUs.empty()) printf(" lat p50=%.2fms p99=%.2fms max=%.2fms", p50, p99, pmax);
+  printf("\n");
+  fflush(stdout);
+}
+
+// ===================== Main =====================
+int main(int argc, char** argv) {
+  if (!parseArgs(argc, argv, g_opt)) { usage(argv[0]); return 2; }
+  signal(SIGINT, onSignal); signal(SIGTERM, onSignal); signal(SIGPIPE, SIG_IGN);
+  g_rng.seed(g_opt.seed);
+
+  if (!resolve(g_opt)) { fprintf(stderr, "cannot resolve %s\n", g_opt.host.c_str()); return 1; }
+  if (g_opt.monitor && !monitorStart()) {
+    fprintf(stderr, "monitor: cannot connect to %s:%u\n", g_opt.host.c_str(), g_opt.port);
+    return 1;
+  }
+
+  for (int b = 0; b < g_opt.beacons; ++b) {
+    char m[18]; snprintf(m, sizeof(m), "dd:88:00:00:%02x:%02x", (b >> 8) & 0xFF, b & 0xFF);
+    g_beaconMacs.emplace_back(m);
+  }
+
+  std::priority_queue<AdvEvent, std::vector<AdvEvent>, std::greater<AdvEvent>> adv;
+  std::uniform_int_distribution<uint32_t> rssiBase(-95 + 200, -45 + 200);
+  g_sensors.resize((size_t)g_opt.sensors);
+  for (int i = 0; i < g_opt.sensors; ++i) {
+    Sensor& s = g_sensors[(size_t)i];
+    char buf[32];
+    s.deviceID  = g_opt.idPrefix + std::to_string(i + 1);
+    snprintf(buf, sizeof(buf), "A0B765%06X", (unsigned)i); s.chipId = buf;
+    snprintf(buf, sizeof(buf), "10.%u.%u.%u", (i >> 16) & 0xFF, (i >> 8) & 0xFF, (i & 0xFF) + 1); s.ip = buf;
+    s.clientId  = "ble-" + s.deviceID;
+    s.willTopic = std::string(DATA_TOPIC) + s.deviceID + "/status";
+    s.bootMs = s.nextRetryMs = g_opt.rampMs ? (uint64_t)(g_rng() % g_opt.rampMs) : 0;
+    s.states.resize((size_t)g_opt.beacons);
+    for (int b = 0; b < g_opt.beacons; ++b) {
+      s.states[(size_t)b].baseRssi = (int)rssiBase(g_rng) - 200;
+      adv.push({s.bootMs + g_rng() % g_opt.advMs, i, b});
+    }
+  }
+
+  printf("loadgen: %d sensors x %d beacons -> %s:%u pubMs=%u advMs=%u jitter=%u duration=%us\n",
+         g_opt.sensors, g_opt.beacons, g_opt.host.c_str(), g_opt.port,
+         g_opt.pubMs, g_opt.advMs, g_opt.jitterMs, g_opt.durationS);
+
+  const uint64_t endMs = g_opt.durationS * 1000ULL;
+  uint64_t nextReport = g_opt.reportS * 1000ULL, lastReport = 0;
+  uint64_t nextStorm  = g_opt.stormEveryS  ? g_opt.stormEveryS  * 1000ULL : UINT64_MAX;
+  uint64_t nextOutage = g_opt.outageEveryS ? g_opt.outageEveryS * 1000ULL : UINT64_MAX;
+  std::uniform_int_distribution<uint32_t> jitter(0, g_opt.jitterMs);
+  std::vector<pollfd> pfds;
+  std::vector<int> owner; // index into g_sensors, -1 for monitor
+
+  for (;;) {
+    uint64_t now = nowMs();
+    bool running = now < endMs && !g_stop;
+    if (!running && now >= endMs + g_opt.drainMs) break;
+    if (g_stop && now < endMs) break;
+
+    if (running) {
+      // Fault injection
+      if (now >= nextStorm) {
+        for (auto& s : g_sensors) if (s.state == SensorState::ONLINE) { sensorLost(s, true); s.nextRetryMs = 0; }
+        nextStorm += g_opt.stormEveryS * 1000ULL;
+      }
+      if (now >= nextOutage) {
+        for (auto& s : g_sensors)
+          if (std::uniform_real_distribution<double>(0, 1)(g_rng) < g_opt.outageFrac) s.wifiDownUntilMs = now + g_opt.outageMs;
+        nextOutage += g_opt.outageEveryS * 1000ULL;
+      }
+      // Beacon advertisements due
+      while (!adv.empty() && adv.top().atMs <= now) {
+        AdvEvent e = adv.top(); adv.pop();
+        sensorOnAdv(g_sensors[(size_t)e.sensor], e.beacon, now);
+        e.atMs += g_opt.advMs + jitter(g_rng);
+        adv.push(e);
+      }
+      for (auto& s : g_sensors) if (now >= s.bootMs) sensorTick(s, now);
+    }
+
+    monitorTick(now);
+
+    // Poll: sensors whose radio is down are left silent (no reads, no writes)
+    pfds.clear(); owner.clear();
+    if (g_mon.fd >= 0) {
+      pfds.push_back({g_mon.fd, (short)(POLLIN | (g_mon.out.empty() ? 0 : POLLOUT)), 0}); owner.push_back(-1);
+    }
+    for (size_t i = 0; i < g_sensors.size(); ++i) {
+      Sensor& s = g_sensors[i];
+      if (s.conn.fd < 0 || !s.wifiUp(now)) continue;
+      short ev = POLLIN;
+      if (s.state == SensorState::TCP_CONNECTING || !s.conn.out.empty()) ev |= POLLOUT;
+      pfds.push_back({s.conn.fd, ev, 0}); owner.push_back((int)i);
+    }
+    int timeout = 1;
+    if (!adv.empty() && running) timeout = (int)std::min<uint64_t>(adv.top().atMs > now ? adv.top().atMs - now : 0, 5);
+    if (poll(pfds.data(), pfds.size(), timeout) < 0 && errno != EINTR) { perror("poll"); return 1; }
+    now = nowMs();
+
+    for (size_t k = 0; k < pfds.size(); ++k) {
+      short re = pfds[k].revents;
+      if (!re) continue;
+      if (owner[k] < 0) {
+        if ((re & POLLIN) && !connRead(g_mon)) { fprintf(stderr, "monitor: connection lost\n"); connClose(g_mon, false); continue; }
+        size_t off = 0; uint8_t hdr; const char* body; size_t len;
+        while (nextPacket(g_mon.in, off, hdr, body, len)) if ((hdr >> 4) == 3) monitorOnPublish(hdr, body, len);
+        g_mon.in.erase(0, off);
+        if ((re & POLLOUT) && !connFlush(g_mon)) connClose(g_mon, false);
+        continue;
+      }
+      Sensor& s = g_sensors[(size_t)owner[k]];
+      if (s.state == SensorState::TCP_CONNECTING) {
+        int err = 0; socklen_t el = sizeof(err);
+        getsockopt(s.conn.fd, SOL_SOCKET, SO_ERROR, &err, &el);
+        if (err || (re & (POLLERR | POLLHUP))) { connClose(s.conn, false); sensorBackoff(s, now); continue; }
+        s.state = SensorState::WAIT_CONNACK;
+      }
+      bool ok = true;
+      if (re & (POLLIN | POLLHUP | POLLERR)) {
+        ok = connRead(s.conn);
+        if (!s.conn.in.empty()) s.lastInMs = now;
+        size_t off = 0; uint8_t hdr; const char* body; size_t len;
+        while (s.conn.fd >= 0 && nextPacket(s.conn.in, off, hdr, body, len)) sensorOnPacket(s, hdr, body, len, now);
+        if (s.conn.fd >= 0) s.conn.in.erase(0, off);
+      }
+      if (s.conn.fd >= 0 && ok && !s.conn.out.empty()) ok = connFlush(s.conn);
+      if (s.conn.fd >= 0 && !ok) {
+        if (s.state == SensorState::ONLINE) sensorLost(s, false);
+        else { connClose(s.conn, false); sensorBackoff(s, now); }
+      }
+    }
+
+    if (now >= nextReport) {
+      report("ivl", g_ivl, (now - lastReport) / 1000.0);
+      g_ivl = Stats{};
+      lastReport = now;
+      nextReport += g_opt.reportS * 1000ULL;
+    }
+  }
+
+  // Whatever the monitor never saw is undelivered
+  for (auto& kv : g_inflight) { g_stats.undelivered += kv.second.size(); }
+  for (auto& s : g_sensors) if (s.conn.fd >= 0) { mqttDisconnect(s.conn.out); connFlush(s.conn); connClose(s.conn, false); }
+
+  double secs = std::min<uint64_t>(nowMs(), endMs) / 1000.0;
+  printf("\n=== Summary (%d sensors x %d beacons, %.1fs) ===\n", g_opt.sensors, g_opt.beacons, secs);
+  report("total", g_stats, secs);
+  printf("sustained: published %.1f msg/s, delivered %.1f msg/s", g_stats.published / secs, g_stats.delivered / secs);
+  if (g_opt.monitor && g_stats.published)
+    printf(", undelivered %llu (%.3f%%)", (unsigned long long)g_stats.undelivered,
+           100.0 * (double)g_stats.undelivered / (double)g_stats.published);
+  printf("\nstatus: online=%llu offline(will)=%llu\n", (unsigned long long)g_stats.online, (unsigned long long)g_stats.offline);
+  static const char* SYS_KEYS[] = {
+    "$SYS/broker/clients/connected", "$SYS/broker/publish/messages/dropped",
+    "$SYS/broker/store/messages/count", "$SYS/broker/load/messages/received/1min",
+    "$SYS/broker/load/messages/sent/1min", "$SYS/broker/heap/current",
+  };
+  for (const char* k : SYS_KEYS) {
+    auto it = g_sys.find(k);
+    if (it != g_sys.end()) printf("%s = %s\n", k, it->second.c_str());
+  }
+  if (g_opt.monitor && g_sys.empty()) printf("(no $SYS/broker stats received; check sys_interval)\n");
+  connClose(g_mon, false);
+  return 0;
+}
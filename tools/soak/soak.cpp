@@ -0,0 +1,394 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (c) 2025 Moniruzzaman Akash
+ * moniruzzaman.akash@unh.edu
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Host-side heap soak for the firmware's scan / publish / HTTP paths.
+//
+// What runs for real: the Arduino-free code src/main.cpp uses (TargetList,
+// rssiEma(), beaconPayload(), configFormHtml(), configToJson(), the JSON
+// block pool), so the headers and sources built here must stay free of
+// Arduino includes. What is modelled: a JsonDoc (one allocation of its
+// capacity), the /status body, the config save around configToJson() (a
+// copy of saveConfigFromJson()), and the WebServer request Strings (args,
+// POST body), which stay on the heap in both modes. Not covered: the
+// handler code itself, GET /log, PubSubClient and the log ring.
+//
+// Two modelled heaps (first fit, the size of the C3's free heap) get the
+// same background "Wi-Fi + NimBLE" churn, which stays live for the whole
+// run and keeps going while responses are being sent; only the test heap
+// also serves the cycle code. At each checkpoint:
+//   - growth: test heap use minus control heap use must stay under
+//     --grow-tol and must not rise at every one of the last checkpoints
+//   - fragmentation: the test heap's largest free block may trail the
+//     control's by at most --frag-tol (placement differs once the cycle
+//     code allocates, so exact equality is not expected)
+//   - no heap allocation may fail, no pool block may leak, no buffer may
+//     overflow
+//   - MEM_BUDGET=1: the firmware's builders and documents make no heap
+//     allocations (WebServer Strings excepted)
+
+#include "config.h"
+#include "mempool.h"
+#include "scan.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// ===================== Modelled heap (first fit, address-ordered free list) =====================
+class Heap {
+ public:
+  void init(size_t bytes) {
+    bytes_ = bytes & ~(kAlign - 1);
+    arena_ = (unsigned char*)std::malloc(bytes_);
+    if (!arena_) { fprintf(stderr, "cannot reserve %zu byte arena\n", bytes_); std::exit(2); }
+    free_ = (Block*)arena_; free_->size = bytes_; free_->next = nullptr;
+  }
+
+  void* alloc(size_t n) {
+    size_t need = ((n + kHdr + kAlign - 1) & ~(kAlign - 1));
+    if (need < sizeof(Block)) need = sizeof(Block);
+    for (Block** pp = &free_; *pp; pp = &(*pp)->next) {
+      Block* b = *pp;
+      if (b->size < need) continue;
+      if (b->size - need >= sizeof(Block) + kAlign) {   // split
+        Block* rest = (Block*)((unsigned char*)b + need);
+        rest->size = b->size - need; rest->next = b->next;
+        *pp = rest; b->size = need;
+      } else {
+        *pp = b->next;
+      }
+      used_ += b->size;
+      return (unsigned char*)b + kHdr;
+    }
+    ++fails_;
+    return nullptr;
+  }
+
+  void free(void* p) {
+    if (!p) return;
+    Block* b = (Block*)((unsigned char*)p - kHdr);
+    used_ -= b->size;
+    Block** pp = &free_;
+    while (*pp && *pp < b) pp = &(*pp)->next;
+    b->next = *pp; *pp = b;
+    if (b->next && (unsigned char*)b + b->size == (unsigned char*)b->next) { b->size += b->next->size; b->next = b->next->next; }
+    if (pp != &free_) {
+      Block* prev = (Block*)((unsigned char*)pp - offsetof(Block, next));
+      if ((unsigned char*)prev + prev->size == (unsigned char*)b) { prev->size += b->size; prev->next = b->next; }
+    }
+  }
+
+  bool owns(const void* p) const { return arena_ && p >= arena_ && p < arena_ + bytes_; }
+  size_t bytes() const { return bytes_; }
+  size_t used() const  { return used_; }
+  unsigned long long fails() const { return fails_; }
+  size_t largestFree() const {
+    size_t m = 0;
+    for (Block* b = free_; b; b = b->next) if (b->size > m) m = b->size;
+    return m > kHdr ? m - kHdr : 0;
+  }
+
+ private:
+  struct Block { size_t size; Block* next; };  // header of a free block; used blocks keep `size`
+  static constexpr size_t kAlign = 8;
+  static constexpr size_t kHdr   = 8;
+  unsigned char* arena_ = nullptr;
+  Block* free_ = nullptr;
+  size_t bytes_ = 0, used_ = 0;
+  unsigned long long fails_ = 0;
+};
+
+static Heap g_test, g_ctrl;                // ctrl: background only
+static bool g_inServer = false;              // allocating on behalf of WebServer
+static unsigned long long g_newCalls = 0;    // by the firmware's own code
+static unsigned long long g_serverNews = 0;  // by the modelled WebServer Strings
+
+void* operator new(size_t n) {
+  if (!g_test.bytes()) { void* p = std::malloc(n); if (!p) throw std::bad_alloc(); return p; }
+  ++(g_inServer ? g_serverNews : g_newCalls);
+  void* p = g_test.alloc(n);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t n) { return ::operator new(n); }
+void operator delete(void* p) noexcept { if (g_test.owns(p)) g_test.free(p); else std::free(p); }
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete(void* p, size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { ::operator delete(p); }
+
+// ===================== Firmware-side state (as in src/main.cpp) =====================
+#if MEM_BUDGET
+static constexpr size_t CFG_DOC_BYTES    = JSON_POOL_BLOCK;
+static constexpr size_t STATUS_DOC_BYTES = JSON_POOL_BLOCK;
+static constexpr size_t CFG_BLOB_LIMIT   = CFG_BLOB_BYTES;
+static char g_httpBuf[HTTP_BUF_BYTES];
+static char g_cfgBlob[CFG_BLOB_BYTES];
+#else
+static constexpr size_t CFG_DOC_BYTES    = 4096;
+static constexpr size_t STATUS_DOC_BYTES = 1024;
+static constexpr size_t CFG_BLOB_LIMIT   = 4096;
+#endif
+
+static const char* CHIP_ID = "A0B765000001";
+static const char* IP      = "192.168.50.12";
+static Config cfg;
+static TargetList targets;
+static const char* MAC_LISTS[] = {
+  "dd:88:00:00:13:07",
+  "dd:88:00:00:13:07, a1:b2:c3:d4:e5:f6",
+  "DD:88:00:00:13:07,a1:b2:c3:d4:e5:f6,11:22:33:44:55:66,de:ad:be:ef:00:01,de:ad:be:ef:00:02,"
+  "de:ad:be:ef:00:03,de:ad:be:ef:00:04,de:ad:be:ef:00:05",
+};
+
+// Stand-in for JsonDoc (ArduinoJson is not built here): both document types
+// take their whole capacity in one allocation for their lifetime.
+class JsonDocModel {
+ public:
+#if MEM_BUDGET
+  explicit JsonDocModel(size_t cap) : p_(JsonPoolAllocator().allocate(cap)) {}
+  ~JsonDocModel() { JsonPoolAllocator().deallocate(p_); }
+#else
+  explicit JsonDocModel(size_t cap) : p_(::operator new(cap, std::nothrow)) {}  // malloc on the device
+  ~JsonDocModel() { ::operator delete(p_); }
+#endif
+  bool ok() const { return p_ != nullptr; }
+ private:
+  void* p_;
+};
+
+// Stand-in for WebServer's parsed request: one String per argument (and the
+// raw body as "plain"), allocated while the request is read, freed after the handler
+class RequestModel {
+ public:
+  void add(const char* value) { g_inServer = true; args_.emplace_back(value); g_inServer = false; }
+  ~RequestModel() { g_inServer = true; args_.clear(); args_.shrink_to_fit(); g_inServer = false; }
+ private:
+  std::vector<std::string> args_;
+};
+
+struct Options {
+  unsigned long long cycles = 5000000ULL;
+  unsigned long long checkEvery = 250000ULL;
+  size_t heapBytes = 160 * 1024;
+  size_t growTol = 256;          // block-split slack in the model, not a leak
+  size_t fragTol = 16 * 1024;    // placement noise between the two heaps
+  unsigned trend = 4;            // checkpoints of monotonic growth that count as a leak
+  unsigned seed = 1;
+};
+
+static std::mt19937 g_rng;
+static unsigned long long g_published = 0, g_overflows = 0, g_httpFails = 0;
+
+static void bgChurn();
+
+// While a response is being sent, Wi-Fi / NimBLE keep allocating in other tasks
+static void sending() { for (int i = 0; i < 8; ++i) bgChurn(); }
+
+// ===================== Cycles =====================
+// onResult(): match, EMA, rate limit, payload into a stack buffer
+static void scanCycle(uint32_t nowMs) {
+  uint8_t val[6];
+  if (targets.count && g_rng() % 4 == 0) {
+    memcpy(val, targets.addr[g_rng() % targets.count], 6);
+  } else {
+    for (auto& b : val) b = (uint8_t)g_rng();
+  }
+  int idx = targets.find(val);
+  if (idx < 0) return;
+  int rssi = -40 - (int)(g_rng() % 60);
+  BeaconState& st = targets.state[idx];
+  st.rssi_ema = rssiEma(st.rssi_ema, rssi);
+  if (nowMs - st.lastPubMs < cfg.pubMs) return;
+
+  BeaconReport rep{CHIP_ID, cfg.deviceID, targets.mac[idx], rssi, st.rssi_ema, 1760000000u + nowMs / 1000, nowMs, IP};
+  char buf[256];
+  if (beaconPayload(rep, buf, sizeof(buf)) >= sizeof(buf)) ++g_overflows;
+  else ++g_published;
+  st.lastPubMs = nowMs;
+}
+
+// GET /status: JsonDoc + sendJson() body (modelled)
+static void statusCycle() {
+  JsonDocModel s(STATUS_DOC_BYTES);
+  if (!s.ok()) { ++g_httpFails; return; }
+  char body[160];
+  snprintf(body, sizeof(body), "{\"chip\":\"%s\",\"mode\":\"STA\",\"ip\":\"%s\",\"heap_free\":%zu}",
+           CHIP_ID, IP, g_test.bytes() - g_test.used());
+#if !MEM_BUDGET
+  std::string out(body);   // String body; serializeJson(d, body)
+#endif
+  sending();
+}
+
+// GET /: sendConfigForm()
+static void formCycle() {
+#if MEM_BUDGET
+  FixedText html(g_httpBuf, sizeof(g_httpBuf));
+  configFormHtml(html, cfg, CHIP_ID, IP, false);
+  if (html.truncated()) ++g_overflows;
+#else
+  std::string html;
+  html.reserve(3000);
+  configFormHtml(html, cfg, CHIP_ID, IP, false);
+#endif
+  sending();
+}
+
+// POST /form or POST /config: request Strings + request doc + saveConfigFromJson();
+// the reboot re-parses the targets
+static void saveCycle(bool form) {
+  Config next = cfg;
+  snprintf(next.macList, sizeof(next.macList), "%s", MAC_LISTS[g_rng() % 3]);
+  next.pubMs = (uint16_t)(50 + g_rng() % 100);
+
+  RequestModel req;
+  if (form) {
+    char port[8], pubMs[8];
+    snprintf(port, sizeof(port), "%u", (unsigned)next.mqttPort);
+    snprintf(pubMs, sizeof(pubMs), "%u", (unsigned)next.pubMs);
+    for (const char* v : { (const char*)"123456", (const char*)next.ssid, (const char*)next.pass, (const char*)next.mqttHost, (const char*)port,
+                           (const char*)next.deviceID, (const char*)next.macList, (const char*)pubMs }) req.add(v);
+  } else {
+    char plain[320];
+    configToJson(next, plain, sizeof(plain));
+    req.add(plain);   // "plain" body
+    req.add(plain);   // http.arg("plain") returns a copy
+  }
+
+  JsonDocModel d(CFG_DOC_BYTES);
+  if (!d.ok()) { ++g_httpFails; return; }
+  size_t len = configToJson(next, nullptr, 0);
+  if (len >= CFG_BLOB_LIMIT) { ++g_overflows; return; }
+#if MEM_BUDGET
+  char* blob = g_cfgBlob;
+#else
+  std::unique_ptr<char[]> owner(new char[len + 1]);
+  char* blob = owner.get();
+#endif
+  if (configToJson(next, blob, len + 1) != len || !strstr(blob, next.macList)) { ++g_httpFails; return; }
+  sending();   // NVS write + "saved" reply
+  cfg = next;
+  targets.parse(cfg.macList);
+}
+
+// ===================== Background (Wi-Fi / NimBLE) churn, same on both heaps =====================
+static constexpr size_t kBgSlots = 48;
+static void* g_bgTest[kBgSlots];
+static void* g_bgCtrl[kBgSlots];
+
+static void bgChurn() {
+  size_t i = g_rng() % kBgSlots;
+  if (g_bgTest[i] || g_bgCtrl[i]) {
+    g_test.free(g_bgTest[i]); g_ctrl.free(g_bgCtrl[i]);
+    g_bgTest[i] = g_bgCtrl[i] = nullptr;
+    return;
+  }
+  static const size_t sizes[] = { 32, 64, 128, 256, 512, 1024, 1600 };   // pbufs, HCI buffers, timers
+  size_t n = sizes[g_rng() % (sizeof(sizes) / sizeof(sizes[0]))];
+  g_bgTest[i] = g_test.alloc(n);
+  g_bgCtrl[i] = g_ctrl.alloc(n);
+}
+
+// ===================== Main =====================
+static bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+    const char* v = nullptr;
+    if      (!strcmp(argv[i], "--cycles") && (v = next()))      o.cycles = strtoull(v, nullptr, 10);
+    else if (!strcmp(argv[i], "--check-every") && (v = next())) o.checkEvery = strtoull(v, nullptr, 10);
+    else if (!strcmp(argv[i], "--heap") && (v = next()))        o.heapBytes = (size_t)strtoull(v, nullptr, 10);
+    else if (!strcmp(argv[i], "--grow-tol") && (v = next()))    o.growTol = (size_t)strtoull(v, nullptr, 10);
+    else if (!strcmp(argv[i], "--frag-tol") && (v = next()))    o.fragTol = (size_t)strtoull(v, nullptr, 10);
+    else if (!strcmp(argv[i], "--trend") && (v = next()))       o.trend = (unsigned)strtoul(v, nullptr, 10);
+    else if (!strcmp(argv[i], "--seed") && (v = next()))        o.seed = (unsigned)strtoul(v, nullptr, 10);
+    else {
+      fprintf(stderr, "Usage: %s [--cycles N] [--check-every N] [--heap BYTES] [--grow-tol BYTES]\n"
+                      "       [--frag-tol BYTES] [--trend CHECKPOINTS] [--seed N]\n", argv[0]);
+      return false;
+    }
+  }
+  return o.checkEvery > 0 && o.trend > 0;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) return 2;
+  g_rng.seed(o.seed);
+  targets.parse(cfg.macList);
+  g_ctrl.init(o.heapBytes);
+  g_test.init(o.heapBytes);
+
+#if MEM_BUDGET
+  printf("soak (MEM_BUDGET=1): %llu cycles, heap model %zu B, static json=%zu http=%zu nvs=%zu scan=%zu\n",
+         o.cycles, g_test.bytes(), JsonPool::kBytes, sizeof(g_httpBuf), sizeof(g_cfgBlob), sizeof(targets));
+#else
+  printf("soak (MEM_BUDGET=0): %llu cycles, heap model %zu B, scan=%zu\n", o.cycles, g_test.bytes(), sizeof(targets));
+#endif
+
+  int rc = 0;
+  long long lastGrowth = 0;
+  unsigned rising = 0;
+  size_t worstFrag = 0;
+  for (unsigned long long c = 1; c <= o.cycles; ++c) {
+    const uint32_t nowMs = (uint32_t)(c * 3);       // ~3 ms per advertisement
+    bgChurn();
+    scanCycle(nowMs);
+    if (c % 101 == 0) {
+      switch ((c / 101) % 4) {
+        case 0:  statusCycle(); break;
+        case 1:  formCycle(); break;
+        case 2:  saveCycle(true); break;
+        default: saveCycle(false); break;
+      }
+    }
+
+    if (c % o.checkEvery && c != o.cycles) continue;
+    const size_t used = g_test.used(), ctrlUsed = g_ctrl.used();
+    const size_t largest = g_test.largestFree(), ctrlLargest = g_ctrl.largestFree();
+    const long long growth = (long long)used - (long long)ctrlUsed;
+    const size_t frag = largest < ctrlLargest ? ctrlLargest - largest : 0;
+    if (frag > worstFrag) worstFrag = frag;
+    rising = (growth > 0 && growth > lastGrowth) ? rising + 1 : 0;
+    lastGrowth = growth;
+    printf("  %10llu cycles  heap used=%zu (%+lld) largest_free=%zu (%+lld) new=%llu server_new=%llu  pool peak=%u  pub=%llu\n",
+           c, used, growth, largest, (long long)largest - (long long)ctrlLargest,
+           g_newCalls, g_serverNews, jsonPool().peak(), g_published);
+    if (growth > (long long)o.growTol) { printf("FAIL: heap use %lld B above control (tolerance %zu)\n", growth, o.growTol); rc = 1; }
+    if (rising >= o.trend)       { printf("FAIL: heap use rose at %u checkpoints in a row\n", rising); rc = 1; }
+    if (frag > o.fragTol)        { printf("FAIL: largest free block %zu B below control (tolerance %zu)\n", frag, o.fragTol); rc = 1; }
+    if (g_test.fails())          { printf("FAIL: %llu heap allocation(s) failed\n", g_test.fails()); rc = 1; }
+#if MEM_BUDGET
+    if (g_newCalls)              { printf("FAIL: %llu heap allocation(s) by firmware builders in budget mode\n", g_newCalls); rc = 1; }
+#endif
+    if (jsonPool().inUse())      { printf("FAIL: JSON pool leaked %u block(s)\n", jsonPool().inUse()); rc = 1; }
+    if (jsonPool().failures() || g_httpFails) { printf("FAIL: pool exhausted (%u) / HTTP cycle failed (%llu)\n", jsonPool().failures(), g_httpFails); rc = 1; }
+    if (g_overflows)             { printf("FAIL: buffer overflow/truncation %llu time(s)\n", g_overflows); rc = 1; }
+    if (rc) break;
+  }
+  printf("worst largest-free gap to control: %zu B\n", worstFrag);
+  printf(rc ? "soak: FAILED\n" : "soak: OK\n");
+  return rc;
+}